@@ -1,27 +1,57 @@
+#include <string.h>
 #include <lua.h>
 #include <lauxlib.h>
 #include "../pb/pb.h"
 #include "../pb/common.h"
 #include "compat.h"
+#include "state.h"
 
 #define PBLUA_METATABLE "PBLua"
-#define PBLUA_DESC_OBJ "PBLuaDesc"
+#define PBLUA_BUFFER_METATABLE "PBLuaBuffer"
 
-void pblua_new_userdata(lua_State *state, pb_message_list_t *msg) {
-    pb_message_list_t **userdata = (pb_message_list_t **) lua_newuserdata(state, sizeof(pb_message_list_t *));
-    *userdata = msg;
+typedef pb_error_t *(*pblua_encoder_t)(pb_message_list_t *, pb_buffer_t *, pb_state_t *, pb_string_t);
+
+typedef struct pblua_codec_t pblua_codec_t;
+
+// releases the schema of a codec when it is collected.
+typedef void (*pblua_release_t)(pblua_codec_t *);
+
+struct pblua_codec_t {
+    pb_message_list_t *msgs;
+    // NULL for the compiled-in descriptor schema, which is never released.
+    pblua_release_t release;
+    // the file a compiled schema is mapped from.
+    pb_file_t file;
+    pblua_encoder_t encode;
+    uint32_t decode_flags;
+    bool raw_access;
+    // the buffer encode reuses, NULL while an encode holds it.
+    pb_buffer_t *out;
+};
+
+void pblua_new_userdata(lua_State *state, pb_message_list_t *msg, pblua_release_t release) {
+    pblua_codec_t *userdata = (pblua_codec_t *) lua_newuserdata(state, sizeof(pblua_codec_t));
+    userdata->msgs = msg;
+    userdata->release = release;
+    userdata->file.data = NULL;
+    userdata->file.size = 0;
+    userdata->file.mapped = false;
+    userdata->encode = pb_encode_message;
+    userdata->decode_flags = 0;
+    userdata->raw_access = false;
+    userdata->out = NULL;
 
     luaL_getmetatable(state, PBLUA_METATABLE);
     lua_setmetatable(state, pb_state_stack_top(-1));
 }
 
-static pb_message_list_t *pblua_check(lua_State *state, int index) {
-    pb_message_list_t **userdata = (pb_message_list_t **) luaL_checkudata(state, index, PBLUA_METATABLE);
+static pblua_codec_t *pblua_check_codec(lua_State *state, int index) {
+    pblua_codec_t *userdata = (pblua_codec_t *) luaL_checkudata(state, index, PBLUA_METATABLE);
     if (!userdata) {
         luaL_error(state, "invalid arguments");
         return NULL;
     }
-    return *userdata;
+    return userdata;
 }
 
 static void pblua_push_and_free_error(lua_State *state, pb_error_t *err) {
@@ -29,93 +59,300 @@ static void pblua_push_and_free_error(lua_State *state, pb_error_t *err) {
     pb_error_free(err);
 }
 
+static void pblua_release_shared(pblua_codec_t *codec) {
+    pb_messages_release(codec->msgs);
+}
+
+static void pblua_release_compiled(pblua_codec_t *codec) {
+    pb_file_unmap(&codec->file);
+}
+
 static int pblua_load_buffer(lua_State *state, pb_buffer_t *buf, pb_error_t *err) {
     pb_message_list_t *msgs = NULL;
     if (!err) {
-        lua_getfield(state, LUA_REGISTRYINDEX, PBLUA_DESC_OBJ);
-        pb_message_list_t *desc = pblua_check(state, pb_state_stack_top(0));
-        lua_pop(state, 1);
-
-        msgs = messages_new();
-        err = pb_messages_parse_pb(desc, buf, msgs);
+        err = pb_messages_acquire(buf, &msgs);
     }
 
     int ret = 1;
     if (err) {
-        if (msgs) {
-            messages_free(msgs);
-        }
         lua_pushnil(state);
         pblua_push_and_free_error(state, err);
         ret++;
     } else {
-        pblua_new_userdata(state, msgs);
+        pblua_new_userdata(state, msgs, pblua_release_shared);
     }
     return ret;
 }
 
 static int pblua_load_file(lua_State *state) {
     const char *fname = lua_tostring(state, pb_state_stack_top(0));
-    pb_buffer_t *buf = pb_buffer_new(1024);
-    pb_error_t *err = pb_read_file(buf, fname);
-
-    int ret = pblua_load_buffer(state, buf, err);
-    pb_buffer_free(buf);
+    pb_file_t file;
+    pb_error_t *err = pb_file_map(&file, fname);
+    if (err) {
+        return pblua_load_buffer(state, NULL, err);
+    }
+    // the file is parsed where it is mapped.
+    pb_buffer_t buf;
+    pb_buffer_wrap(&buf, file.data, file.size);
+    int ret = pblua_load_buffer(state, &buf, NULL);
+    pb_file_unmap(&file);
     return ret;
 }
 
 static int pblua_load_string(lua_State *state) {
-    pb_buffer_t *buf = pb_buffer_new(1024);
     size_t len = 0;
     const char *pbcontent = lua_tolstring(state, pb_state_stack_top(0), &len);
-    pb_buffer_write(buf, (const uint8_t *) pbcontent, len);
+    // the string is parsed in place, it is on the stack until the load returns.
+    pb_buffer_t buf;
+    pb_buffer_wrap(&buf, (const uint8_t *) pbcontent, len);
+    return pblua_load_buffer(state, &buf, NULL);
+}
 
-    int ret = pblua_load_buffer(state, buf, NULL);
+// compiles the FileDescriptorSet in pbfile into outfile, for loadcompiled.
+static int pblua_compile(lua_State *state) {
+    const char *pbfile = lua_tostring(state, pb_state_stack_bottom(0)),
+        *outfile = lua_tostring(state, pb_state_stack_bottom(1));
+    pb_message_list_t *msgs = messages_new();
+    pb_buffer_t *buf = pb_buffer_new(1024);
+    pb_error_t *err = pb_messages_parse_pbfile(pbfile, msgs);
+    if (!err) {
+        err = pb_messages_compile(msgs, buf);
+    }
+    if (!err) {
+        err = pb_write_file(buf, outfile);
+    }
     pb_buffer_free(buf);
-    return ret;
+    messages_free(msgs);
+    if (err) {
+        lua_pushnil(state);
+        pblua_push_and_free_error(state, err);
+        return 2;
+    }
+    lua_pushboolean(state, 1);
+    return 1;
+}
+
+// the codec of a compiled schema, used in place of the mapped file. the codec is created first and
+// owns the mapping as soon as there is one, nothing that may raise comes between them.
+static int pblua_load_compiled(lua_State *state) {
+    const char *fname = lua_tostring(state, pb_state_stack_top(0));
+    pblua_new_userdata(state, NULL, NULL);
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_top(0));
+    pb_error_t *err = pb_file_map(&codec->file, fname);
+    if (err) {
+        lua_pushnil(state);
+        pblua_push_and_free_error(state, err);
+        return 2;
+    }
+    codec->release = pblua_release_compiled;
+    err = pb_messages_map(codec->file.data, codec->file.size, &codec->msgs);
+    if (err) {
+        // the mapping is not kept until the codec is collected.
+        codec->release = NULL;
+        pb_file_unmap(&codec->file);
+        lua_pushnil(state);
+        pblua_push_and_free_error(state, err);
+        return 2;
+    }
+    return 1;
+}
+
+static pb_buffer_t **pblua_check_buffer(lua_State *state, int index) {
+    return (pb_buffer_t **) luaL_checkudata(state, index, PBLUA_BUFFER_METATABLE);
+}
+
+// appends the message at the top, named by the value below it, to buf. nothing is appended on error.
+static pb_error_t *pblua_encode_buffer(lua_State *state, pblua_codec_t *codec, pb_buffer_t *buf) {
+    pb_state_t s;
+    pb_state_init(&s, state);
+    pb_state_set_raw_access(&s, codec->raw_access);
+    size_t size = pb_buffer_size(buf);
+    pb_error_t *err = codec->encode(codec->msgs, buf, &s, pb_state_get_string(&s, pb_state_stack_top(-1)));
+    if (err) {
+        pb_buffer_truncate(buf, size);
+    }
+    return err;
 }
 
 static int pblua_encode(lua_State *state) {
-    pb_message_list_t *msg = pblua_check(state, pb_state_stack_bottom(0));
-    pb_buffer_t *buf = pb_buffer_new(1024);
-    pb_state_t *s = pb_state_new(state);
-    pb_error_t *err = pb_encode_message(msg, buf, s, pb_state_get_string(s, pb_state_stack_top(-1)));
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    // the buffer of the codec is taken for the call, a nested encode gets a new one.
+    pb_buffer_t *buf = codec->out;
+    codec->out = NULL;
+    if (buf) {
+        pb_buffer_reset(buf);
+    } else {
+        buf = pb_buffer_new(1024);
+    }
+    pb_error_t *err = pblua_encode_buffer(state, codec, buf);
     int ret = 1;
     if (err) {
         lua_pushnil(state);
         pblua_push_and_free_error(state, err);
         ret++;
     } else {
-        pb_state_push_string(s, pb_buffer_payload(buf, pb_buffer_size(buf)));
+        pb_string_t str = pb_buffer_payload(buf, pb_buffer_size(buf));
+        lua_pushlstring(state, str.str, str.len);
+    }
+    if (codec->out) {
+        pb_buffer_free(buf);
+    } else {
+        codec->out = buf;
     }
-    pb_buffer_free(buf);
-    pb_state_free(s);
     return ret;
 }
 
+// appends the encoded message to a buffer and returns the buffer.
+static int pblua_encode_into(lua_State *state) {
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    pb_buffer_t *buf = *pblua_check_buffer(state, pb_state_stack_bottom(1));
+    pb_error_t *err = pblua_encode_buffer(state, codec, buf);
+    if (err) {
+        lua_pushnil(state);
+        pblua_push_and_free_error(state, err);
+        return 2;
+    }
+    lua_pushvalue(state, pb_state_stack_bottom(1));
+    return 1;
+}
+
+// output buffers keep their capacity across encodes.
+static int pblua_buffer_new(lua_State *state) {
+    lua_Integer cap = luaL_optinteger(state, pb_state_stack_bottom(0), 1024);
+    if (cap < 0) {
+        return luaL_argerror(state, pb_state_stack_bottom(0), "negative capacity");
+    }
+    pb_buffer_t **userdata = (pb_buffer_t **) lua_newuserdata(state, sizeof(pb_buffer_t *));
+    *userdata = pb_buffer_new((size_t) cap);
+    luaL_getmetatable(state, PBLUA_BUFFER_METATABLE);
+    lua_setmetatable(state, pb_state_stack_top(-1));
+    return 1;
+}
+
+static int pblua_buffer_tostring(lua_State *state) {
+    pb_buffer_t *buf = *pblua_check_buffer(state, pb_state_stack_bottom(0));
+    pb_string_t str = pb_buffer_payload(buf, pb_buffer_size(buf));
+    lua_pushlstring(state, str.str, str.len);
+    return 1;
+}
+
+static int pblua_buffer_len(lua_State *state) {
+    pb_buffer_t *buf = *pblua_check_buffer(state, pb_state_stack_bottom(0));
+    lua_pushinteger(state, (lua_Integer) pb_buffer_size(buf));
+    return 1;
+}
+
+static int pblua_buffer_reset(lua_State *state) {
+    pb_buffer_reset(*pblua_check_buffer(state, pb_state_stack_bottom(0)));
+    return 0;
+}
+
+// the address of the content, valid until the next change of the buffer.
+static int pblua_buffer_pointer(lua_State *state) {
+    pb_buffer_t *buf = *pblua_check_buffer(state, pb_state_stack_bottom(0));
+    lua_pushlightuserdata(state, (void *) pb_buffer_payload(buf, 0).str);
+    return 1;
+}
+
+static int pblua_buffer_free(lua_State *state) {
+    pb_buffer_t **userdata = pblua_check_buffer(state, pb_state_stack_bottom(0));
+    if (*userdata) {
+        pb_buffer_free(*userdata);
+        *userdata = NULL;
+    }
+    return 0;
+}
+
 static int pblua_decode(lua_State *state) {
-    pb_message_list_t *msg = pblua_check(state, pb_state_stack_bottom(0));
-    pb_buffer_t *buf = pb_buffer_new(1024);
-    pb_state_t *s = pb_state_new(state);
-    pb_string_t msg_name = pb_state_get_string(s, pb_state_stack_top(-1));
-    pb_string_t data = pb_state_get_string(s, pb_state_stack_top(0));
-    pb_buffer_write(buf, (const uint8_t *) data.str, data.len);
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    pb_state_t s;
+    pb_state_init(&s, state);
+    pb_string_t msg_name = pb_state_get_string(&s, pb_state_stack_top(-1));
+    // the data is read in place, it stays on the stack as an argument until the call returns.
+    pb_string_t data = pb_state_get_string(&s, pb_state_stack_top(0));
+    pb_buffer_t buf;
+    pb_buffer_wrap(&buf, (const uint8_t *) data.str, data.len);
 
-    pb_error_t *err = pb_decode_message(msg, buf, s, msg_name);
+    pb_error_t *err = pb_decode_message_flags(codec->msgs, &buf, &s, msg_name, codec->decode_flags);
     int ret = 1;
     if (err) {
         lua_pushnil(state);
         pblua_push_and_free_error(state, err);
         ret++;
     }
-    pb_buffer_free(buf);
-    pb_state_free(s);
     return ret;
 }
 
+// selects the encoder of the codec: "forward" (default), "reverse" or "sized".
+static int pblua_set_encoder(lua_State *state) {
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    const char *name = luaL_checkstring(state, pb_state_stack_bottom(1));
+    if (strcmp(name, "forward") == 0) {
+        codec->encode = pb_encode_message;
+    } else if (strcmp(name, "reverse") == 0) {
+        codec->encode = pb_encode_message_reverse;
+    } else if (strcmp(name, "sized") == 0) {
+        codec->encode = pb_encode_message_sized;
+    } else {
+        return luaL_error(state, "unknown encoder: %s", name);
+    }
+    return 0;
+}
+
+// selects how absent fields are decoded: "eager" (default) sets new defaults in every message,
+// "shared" shares read-only defaults for message and repeated fields, "lazy" leaves them out and
+// serves them from a metatable shared by the message type.
+static int pblua_set_defaults(lua_State *state) {
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    const char *name = luaL_checkstring(state, pb_state_stack_bottom(1));
+    uint32_t flags = codec->decode_flags & ~(PB_DECODE_LAZY_DEFAULTS | PB_DECODE_SHARED_DEFAULTS);
+    if (strcmp(name, "eager") == 0) {
+        codec->decode_flags = flags;
+    } else if (strcmp(name, "shared") == 0) {
+        codec->decode_flags = flags | PB_DECODE_SHARED_DEFAULTS;
+    } else if (strcmp(name, "lazy") == 0) {
+        codec->decode_flags = flags | PB_DECODE_LAZY_DEFAULTS;
+    } else {
+        return luaL_error(state, "unknown defaults: %s", name);
+    }
+    return 0;
+}
+
+// selects how encoded messages are read: "meta" (default) honors their metamethods, "raw" skips them.
+static int pblua_set_access(lua_State *state) {
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    const char *name = luaL_checkstring(state, pb_state_stack_bottom(1));
+    if (strcmp(name, "meta") == 0) {
+        codec->raw_access = false;
+    } else if (strcmp(name, "raw") == 0) {
+        codec->raw_access = true;
+    } else {
+        return luaL_error(state, "unknown access: %s", name);
+    }
+    return 0;
+}
+
 static int pblua_free(lua_State *state) {
-    pb_message_list_t *msg = pblua_check(state, pb_state_stack_bottom(0));
-    messages_free(msg);
+    pblua_codec_t *codec = pblua_check_codec(state, pb_state_stack_bottom(0));
+    pb_message_list_t *msgs = codec->msgs;
+    // the cached defaults and names are keyed by message and list, drop them before they go away.
+    // a codec whose load failed has no list.
+    if (msgs) {
+        pb_state_t s;
+        pb_state_init(&s, state);
+        for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg)) {
+            pb_state_clear_cached_defaults(&s, msg);
+        }
+        pb_state_clear_cached_names(&s, msgs);
+    }
+    if (codec->release) {
+        codec->release(codec);
+        codec->release = NULL;
+    }
+    if (codec->out) {
+        pb_buffer_free(codec->out);
+        codec->out = NULL;
+    }
     return 0;
 }
 //
@@ -135,7 +372,11 @@ int luaopen_pblua(lua_State *state) {
     luaL_newmetatable(state, PBLUA_METATABLE);
     luaL_Reg meta[] = {
         {"encode", pblua_encode},
+        {"encode_into", pblua_encode_into},
         {"decode", pblua_decode},
+        {"setencoder", pblua_set_encoder},
+        {"setdefaults", pblua_set_defaults},
+        {"setaccess", pblua_set_access},
         {"__gc",   pblua_free},
 //        {"__index", pblua_index},
         {NULL, NULL}
@@ -144,28 +385,37 @@ int luaopen_pblua(lua_State *state) {
     lua_pushvalue(state, pb_state_stack_top(0));
     lua_setfield(state, pb_state_stack_top(-1), "__index");
 
-    pb_message_list_t *desc = messages_new();
-    pb_error_t *err = pb_messages_new_descriptor(desc);
-
-    int ret = 1;
-    if (err) {
-        lua_pushnil(state);
-        pblua_push_and_free_error(state, err);
-        ret++;
-        return ret;
-    }
-    pblua_new_userdata(state, desc);
-    lua_setfield(state, LUA_REGISTRYINDEX, PBLUA_DESC_OBJ);
+    luaL_newmetatable(state, PBLUA_BUFFER_METATABLE);
+    luaL_Reg buffer_meta[] = {
+        {"tostring", pblua_buffer_tostring},
+        {"len",      pblua_buffer_len},
+        {"reset",    pblua_buffer_reset},
+        {"pointer",  pblua_buffer_pointer},
+        {"__len",    pblua_buffer_len},
+        {"__gc",     pblua_buffer_free},
+        {NULL, NULL}
+    };
+    pblua_compat_setfuncs(state, buffer_meta);
+    lua_pushvalue(state, pb_state_stack_top(0));
+    lua_setfield(state, pb_state_stack_top(-1), "__index");
+    lua_pop(state, 1);
 
     luaL_Reg lib[] = {
         {"loadfile",   pblua_load_file},
         {"loadstring", pblua_load_string},
+        {"compile",    pblua_compile},
+        {"loadcompiled", pblua_load_compiled},
+        {"buffer",     pblua_buffer_new},
         {NULL, NULL}
     };
     pblua_compat_newlib(state, "pblua", lib);
 
-    pb_state_t *s = pb_state_new(state);
-    pb_state_register_pb_types(s);
-    pb_state_free(s);
-    return ret;
+    pb_state_t s;
+    pb_state_init(&s, state);
+    pb_state_register_pb_types(&s);
+
+    // pblua.descriptor decodes .pb files, its schema is compiled in.
+    pblua_new_userdata(state, pb_messages_descriptor(), NULL);
+    lua_setfield(state, pb_state_stack_top(-1), "descriptor");
+    return 1;
 }
\ No newline at end of file
@@ -1,272 +1,351 @@
 #include <stdbool.h>
+#include <string.h>
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
 #include "../pb/pb.h"
 #include "compat.h"
-#include "luafile_gen.h"
+#define PBLUA_STATE_IMPL
+#include "state.h"
 
-struct pb_state_t {
-    lua_State *state;
-    bool first_key_pushed;
-};
-
-inline void *pb_state_new_raw() {
-    return luaL_newstate();
+void pb_state_init(pb_state_t *state, void *raw) {
+    memset(state, 0, sizeof(pb_state_t));
+    state->state = (lua_State *) raw;
 }
 
-inline void pb_state_free_raw(void *s) {
-    lua_close(s);
-}
+#define PB_STATE_NAMES "PBLuaNames"
 
-inline pb_state_t *pb_state_new(void *state) {
-    pb_state_t *s = (pb_state_t *) calloc(1, sizeof(pb_state_t));
-    s->state = (lua_State *) state;
-    return s;
-}
+// the interned names are kept at the bottom of the stack, out of the way of the values.
+#define NAMES_STACK_INDEX 1
 
-inline void pb_state_free(pb_state_t *state) {
-    free(state);
+bool pb_state_use_names(pb_state_t *state, const void *key, size_t count) {
+    lua_State *L = state->state;
+    lua_getfield(L, LUA_REGISTRYINDEX, PB_STATE_NAMES);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, PB_STATE_NAMES);
+    }
+    lua_pushlightuserdata(L, (void *) key);
+    lua_rawget(L, -2);
+    bool created = lua_isnil(L, -1);
+    if (created) {
+        lua_pop(L, 1);
+        lua_createtable(L, (int) count, 0);
+        lua_pushlightuserdata(L, (void *) key);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, -4);
+    }
+    lua_remove(L, -2);
+    lua_insert(L, NAMES_STACK_INDEX);
+    state->names = NAMES_STACK_INDEX;
+    return created;
 }
 
-inline int pb_state_stack_top(int offset) {
-    return -1 + offset;
+void pb_state_add_name(pb_state_t *state, size_t index, pb_string_t name) {
+    lua_State *L = state->state;
+    lua_pushlstring(L, name.str, name.len);
+    lua_rawseti(L, state->names, (int) index + 1);
 }
 
-inline int pb_state_stack_bottom(int offset) {
-    return 1 + offset;
+void pb_state_release_names(pb_state_t *state) {
+    if (state->names) {
+        lua_remove(state->state, state->names);
+        state->names = 0;
+    }
 }
 
-inline int32_t pb_state_get_int32(pb_state_t *state, int sindex) {
-    return (int32_t) lua_tointeger(state->state, sindex);
-}
+void pb_state_clear_cached_names(pb_state_t *state, const void *key) {
+    lua_State *L = state->state;
+    lua_getfield(L, LUA_REGISTRYINDEX, PB_STATE_NAMES);
+    if (!lua_isnil(L, -1)) {
+        lua_pushlightuserdata(L, (void *) key);
+        lua_pushnil(L);
+        lua_rawset(L, -3);
+    }
+    lua_pop(L, 1);
+}
+
+#define PB_STATE_DEFAULTS "PBLuaDefaults"
+
+// the slots of a cached defaults entry, the metatable of the read-only map keeps the names and the
+// defaults by ordinal in the same slots.
+enum {
+    // the field names by ordinal.
+    DEFAULTS_NAMES = 1,
+    // the defaults by ordinal.
+    DEFAULTS_ORDINALS,
+    // the defaults by name.
+    DEFAULTS_VALUES,
+    // the names of the fields whose default is a new empty map.
+    DEFAULTS_EMPTY,
+    // the metatable serving the defaults lazily.
+    DEFAULTS_META,
+    // an empty read-only map serving the defaults.
+    DEFAULTS_SHARED,
+};
 
-inline int64_t pb_state_get_int64(pb_state_t *state, int sindex) {
-    return (int64_t) lua_tointeger(state->state, sindex);
-}
+// nesting of copied defaults, deeper ones and recursive ones are copied empty.
+#define DEFAULTS_COPY_MAX_DEPTH 32
 
-inline uint32_t pb_state_get_uint32(pb_state_t *state, int sindex) {
-    return (uint32_t) lua_tounsigned(state->state, sindex);
-}
+// the slots one level of building, sharing or copying defaults uses at most. the levels recurse
+// with the nesting of the messages, so each one makes sure of its own.
+#define DEFAULTS_STACK_SLOTS 8
 
-inline uint64_t pb_state_get_uint64(pb_state_t *state, int sindex) {
-    return (uint64_t) lua_tounsigned(state->state, sindex);
+static void state_check_defaults_stack(lua_State *L) {
+    luaL_checkstack(L, DEFAULTS_STACK_SLOTS, "message defaults nested too deep");
 }
 
-inline float pb_state_get_float(pb_state_t *state, int sindex) {
-    return (float) lua_tonumber(state->state, sindex);
+// pushes the registry table of cached defaults entries.
+static void state_push_defaults_cache(lua_State *L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, PB_STATE_DEFAULTS);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, PB_STATE_DEFAULTS);
+    }
 }
 
-inline double pb_state_get_double(pb_state_t *state, int sindex) {
-    return (double) lua_tonumber(state->state, sindex);
+// pushes the cached defaults entry of key, nil if there is none.
+static void state_push_defaults_entry(lua_State *L, const void *key) {
+    state_push_defaults_cache(L);
+    lua_pushlightuserdata(L, (void *) key);
+    lua_rawget(L, -2);
+    lua_remove(L, -2);
 }
 
-inline bool pb_state_get_bool(pb_state_t *state, int sindex) {
-    return (bool) lua_toboolean(state->state, sindex);
+static int state_readonly_error(lua_State *L) {
+    return luaL_error(L, "attempt to modify a shared default value");
 }
 
-inline pb_string_t pb_state_get_string(pb_state_t *state, int sindex) {
-    pb_string_t str;
-    str.str = lua_tolstring(state->state, sindex, &str.len);
-    return str;
+// the default of repeated and map fields, stands for a new empty map wherever it is set.
+static const char state_empty_default;
+
+static bool state_is_empty_default(lua_State *L, int index) {
+    return lua_touserdata(L, index) == &state_empty_default;
 }
 
-inline size_t pb_state_get_objlen(pb_state_t *state, int sindex) {
-    return lua_objlen(state->state, sindex);
+void pb_state_push_empty_default(pb_state_t *state) {
+    lua_pushlightuserdata(state->state, (void *) &state_empty_default);
 }
 
-bool pb_state_iter_map_element_pair(pb_state_t *state) {
-    if (!state->first_key_pushed) {
-        state->first_key_pushed = true;
-        lua_pushnil(state->state);
+// the __index of the defaults by name, serves a new empty map for the names of repeated and map
+// fields, a shared one could be changed with raw writes.
+static int state_empty_index(lua_State *L) {
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    if (!lua_isnil(L, -1)) {
+        lua_newtable(L);
     }
-    if (!lua_next(state->state, pb_state_stack_top(-1))) {
-        state->first_key_pushed = false;
-        return false;
-    }
-    return true;
+    return 1;
 }
 
-inline static bool state_pop_if_nil(pb_state_t *state) {
-    if (lua_isnil(state->state, pb_state_stack_top(0))) {
-        pb_state_pop(state);
+// the __index of lazily served defaults. repeated and map fields get a new empty map on first
+// access, kept in the message so changes to it stay there.
+static int state_lazy_index(lua_State *L) {
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    if (!lua_isnil(L, -1)) {
+        return 1;
+    }
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(2));
+    if (lua_isnil(L, -1)) {
+        return 1;
+    }
+    lua_newtable(L);
+    lua_pushvalue(L, 2);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, 1);
+    return 1;
+}
+
+bool pb_state_push_new_defaults(pb_state_t *state, const void *key, size_t size) {
+    lua_State *L = state->state;
+    state_check_defaults_stack(L);
+    state_push_defaults_entry(L, key);
+    if (!lua_isnil(L, -1)) {
+        lua_pop(L, 1);
         return false;
     }
+    lua_pop(L, 1);
+
+    lua_createtable(L, DEFAULTS_SHARED, 0);
+    int entry = lua_gettop(L);
+    lua_createtable(L, (int) size, 0);
+    lua_rawseti(L, entry, DEFAULTS_NAMES);
+    lua_createtable(L, (int) size, 0);
+    lua_rawseti(L, entry, DEFAULTS_ORDINALS);
+    lua_newtable(L);
+    lua_rawseti(L, entry, DEFAULTS_EMPTY);
+    lua_createtable(L, 0, (int) size);
+    lua_createtable(L, 0, 1);
+    lua_rawgeti(L, entry, DEFAULTS_EMPTY);
+    lua_pushcclosure(L, state_empty_index, 1);
+    lua_setfield(L, -2, "__index");
+    lua_setmetatable(L, -2);
+    lua_rawseti(L, entry, DEFAULTS_VALUES);
+
+    lua_createtable(L, 0, 1);
+    lua_rawgeti(L, entry, DEFAULTS_VALUES);
+    lua_rawgeti(L, entry, DEFAULTS_EMPTY);
+    lua_pushcclosure(L, state_lazy_index, 2);
+    lua_setfield(L, -2, "__index");
+    lua_rawseti(L, entry, DEFAULTS_META);
+
+    // the metatable is hidden, the defaults behind the read-only map cannot be reached. raw writes
+    // to the map itself are not caught, callers must not make them.
+    lua_newtable(L);
+    lua_createtable(L, 2, 3);
+    lua_rawgeti(L, entry, DEFAULTS_VALUES);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, state_readonly_error);
+    lua_setfield(L, -2, "__newindex");
+    lua_pushboolean(L, 0);
+    lua_setfield(L, -2, "__metatable");
+    lua_rawgeti(L, entry, DEFAULTS_NAMES);
+    lua_rawseti(L, -2, DEFAULTS_NAMES);
+    lua_rawgeti(L, entry, DEFAULTS_ORDINALS);
+    lua_rawseti(L, -2, DEFAULTS_ORDINALS);
+    lua_setmetatable(L, -2);
+    lua_rawseti(L, entry, DEFAULTS_SHARED);
+
+    // cached before it is filled.
+    state_push_defaults_cache(L);
+    lua_pushlightuserdata(L, (void *) key);
+    lua_pushvalue(L, entry);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
     return true;
 }
 
-inline void pb_state_get_array_element(pb_state_t *state, int sindex, int index) {
-    // lua is 1-index based.
-    pb_state_push_array_index(state, index);
-    lua_rawget(state->state, sindex - 1);
-}
-
-inline bool pb_state_get_map_element(pb_state_t *state, int sindex, pb_string_t key) {
-    pb_state_push_map_key(state, key);
-    lua_gettable(state->state, sindex - 1);
-    return state_pop_if_nil(state);
-}
-
-pb_statetype_t pb_state_get_type(pb_state_t *state, int sindex) {
-    switch (lua_type(state->state, sindex)) {
-        case LUA_TNIL:
-            return PB_STATE_NIL;
-        case LUA_TNUMBER:
-            return PB_STATE_NUMBER;
-        case LUA_TSTRING:
-            return PB_STATE_STRING;
-        case LUA_TBOOLEAN:
-            return PB_STATE_BOOLEAN;
-        case LUA_TTABLE:
-            return PB_STATE_OBJECT;
-        default:
-            return PB_STATE_OTHER;
+void pb_state_add_default(pb_state_t *state, size_t ordinal) {
+    lua_State *L = state->state;
+    state_check_defaults_stack(L);
+    int entry = lua_gettop(L) - 2;
+    lua_rawgeti(L, entry, state_is_empty_default(L, -1) ? DEFAULTS_EMPTY : DEFAULTS_VALUES);
+    lua_pushvalue(L, -3);
+    lua_pushvalue(L, -3);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+
+    lua_rawgeti(L, entry, DEFAULTS_ORDINALS);
+    lua_insert(L, -2);
+    lua_rawseti(L, -2, (int) ordinal + 1);
+    lua_pop(L, 1);
+
+    lua_rawgeti(L, entry, DEFAULTS_NAMES);
+    lua_insert(L, -2);
+    lua_rawseti(L, -2, (int) ordinal + 1);
+    lua_pop(L, 1);
+}
+
+void pb_state_push_shared_defaults(pb_state_t *state, const void *key) {
+    lua_State *L = state->state;
+    state_check_defaults_stack(L);
+    state_push_defaults_entry(L, key);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        if (key) {
+            lua_newtable(L);
+            return;
+        }
+        pb_state_push_new_defaults(state, NULL, 0);
     }
+    lua_rawgeti(L, -1, DEFAULTS_SHARED);
+    lua_remove(L, -2);
 }
 
-inline void pb_state_push_nil(pb_state_t *state) {
-    lua_pushnil(state->state);
-}
-
-inline void pb_state_push_int32(pb_state_t *state, int32_t n) {
-    lua_pushinteger(state->state, (lua_Integer) n);
-}
-
-inline void pb_state_push_int64(pb_state_t *state, int64_t n) {
-    lua_pushinteger(state->state, (lua_Integer) n);
-}
-
-inline void pb_state_push_uint32(pb_state_t *state, uint32_t n) {
-    lua_pushunsigned(state->state, (lua_Unsigned) n);
-}
-
-inline void pb_state_push_uint64(pb_state_t *state, uint64_t n) {
-    lua_pushunsigned(state->state, (lua_Unsigned) n);
-}
-
-inline void pb_state_push_float(pb_state_t *state, float f) {
-    lua_pushnumber(state->state, (lua_Number) f);
-}
-
-inline void pb_state_push_double(pb_state_t *state, double d) {
-    lua_pushnumber(state->state, (lua_Number) d);
-}
-
-inline void pb_state_push_bool(pb_state_t *state, bool b) {
-    lua_pushboolean(state->state, (int) b);
-}
-
-inline void pb_state_push_string(pb_state_t *state, pb_string_t s) {
-    lua_pushlstring(state->state, s.str, s.len);
-}
-
-inline void pb_state_push_array(pb_state_t *state) {
-    lua_newtable(state->state);
-}
-
-inline void pb_state_push_map(pb_state_t *state) {
-    lua_newtable(state->state);
-}
-
-inline void pb_state_push_array_index(pb_state_t *state, int index) {
-    pb_state_push_int32(state, index + 1);
-}
-
-inline void pb_state_push_map_key(pb_state_t *state, pb_string_t key) {
-    pb_state_push_string(state, key);
-}
-
-inline void pb_state_append_array_element(pb_state_t *state) {
-    lua_settable(state->state, pb_state_stack_top(-2));
-}
-
-inline void pb_state_set_map_element(pb_state_t *state) {
-    lua_settable(state->state, pb_state_stack_top(-2));
-}
-
-inline void pb_state_popn(pb_state_t *state, size_t n) {
-    lua_pop(state->state, n);
-}
-
-inline void pb_state_pop(pb_state_t *state) {
-    pb_state_popn(state, 1);
-}
-
-bool pb_is_state_type_compatible(pb_statetype_t t, pb_valtype_t v) {
-    switch (t) {
-        case PB_STATE_NUMBER:
-        case PB_STATE_BOOLEAN:
-            return v == PB_VAL_SINT32 ||
-                   v == PB_VAL_SINT64 ||
-                   v == PB_VAL_INT32 ||
-                   v == PB_VAL_INT64 ||
-                   v == PB_VAL_UINT32 ||
-                   v == PB_VAL_UINT64 ||
-                   v == PB_VAL_FIXED32 ||
-                   v == PB_VAL_FIXED64 ||
-                   v == PB_VAL_SFIXED32 ||
-                   v == PB_VAL_SFIXED64 ||
-                   v == PB_VAL_FLOAT ||
-                   v == PB_VAL_DOUBLE ||
-                   v == PB_VAL_BOOL ||
-                   v == PB_VAL_ENUM;
-        case PB_STATE_STRING:
-            return v == PB_VAL_STRING ||
-                   v == PB_VAL_BYTES;
-        case PB_STATE_OBJECT:
-            return v == PB_VAL_MAP ||
-                   v == PB_VAL_MESSAGE ||
-                   v == PB_VAL_ANY;
-        case PB_STATE_NIL:
-        case PB_STATE_OTHER:
-        default:
-            return false;
+// pushes a copy of the default at index, read-only maps are copied into new maps. ancestors holds
+// the names of the maps being copied, ancestors[0] those of the shared empty map.
+static void state_push_default_copy(lua_State *L, int index, int *ancestors, int depth) {
+    state_check_defaults_stack(L);
+    if (state_is_empty_default(L, index)) {
+        lua_newtable(L);
+        return;
     }
-}
-
-inline static const char *state_error(pb_state_t *state) {
-    return lua_tostring(state->state, -1);
-}
-
-pb_error_t *pb_state_push_descriptor_meta(pb_state_t *state) {
-    pb_state_push_map(state);
-    pb_state_register_pb_types(state);
-    lua_setglobal(state->state, "pbtypes");
-
-    int err = luaL_loadbuffer(state->state, (const char *) lua_desc_lua, lua_desc_lua_len, NULL) ||
-              lua_pcall(state->state, 0, LUA_MULTRET, 0);
-    if (err) {
-        return pb_error_new(PB_ERR_FAIL, "load FileDescriptorSet failed: %s", state_error(state));
+    if (!lua_istable(L, index) || !lua_getmetatable(L, index)) {
+        lua_pushvalue(L, index);
+        return;
+    }
+    lua_rawgeti(L, -1, DEFAULTS_NAMES);
+    lua_rawgeti(L, -2, DEFAULTS_ORDINALS);
+    lua_remove(L, -3);
+    int names = lua_gettop(L) - 1,
+        ordinals = names + 1,
+        size = (int) lua_objlen(L, names);
+
+    bool recursive = depth >= DEFAULTS_COPY_MAX_DEPTH || size == 0;
+    for (int i = 0; i < depth && !recursive; i++) {
+        recursive = lua_rawequal(L, ancestors[i], names);
+    }
+    lua_createtable(L, 0, recursive ? 0 : size);
+    if (!recursive) {
+        int copy = lua_gettop(L);
+        ancestors[depth] = names;
+        for (int i = 1; i <= size; i++) {
+            lua_rawgeti(L, names, i);
+            lua_rawgeti(L, ordinals, i);
+            if (lua_isnil(L, -1)) {
+                lua_pop(L, 2);
+                continue;
+            }
+            state_push_default_copy(L, copy + 2, ancestors, depth + 1);
+            lua_remove(L, -2);
+            lua_rawset(L, copy);
+        }
+    }
+    lua_insert(L, names);
+    lua_pop(L, 2);
+}
+
+void pb_state_set_defaults(pb_state_t *state, const void *key, pb_defaults_mode_t mode, const uint64_t *present) {
+    lua_State *L = state->state;
+    state_check_defaults_stack(L);
+    int target = lua_gettop(L);
+    state_push_defaults_entry(L, key);
+    if (mode == PB_DEFAULTS_LAZY) {
+        lua_rawgeti(L, -1, DEFAULTS_META);
+        lua_setmetatable(L, target);
+        lua_pop(L, 1);
+        return;
     }
-    lua_getglobal(state->state, "descriptor");
-    return NULL;
-}
-
-inline const char *pb_state_descriptor_type() {
-    return "FileDescriptorSet";
-}
-
-pb_error_t *pb_state_push_descriptor_parser(pb_state_t *state) {
-    luaL_openlibs(state->state);
-    pb_state_push_map(state);
-    pb_state_register_pb_types(state);
-    lua_setglobal(state->state, "pbtypes");
 
-    int err = luaL_loadbuffer(state->state, (const char *) lua_parse_lua, lua_parse_lua_len, NULL) ||
-              lua_pcall(state->state, 0, LUA_MULTRET, 0);
-    if (err) {
-        return pb_error_new(PB_ERR_FAIL, "load descriptor parser failed: %s", state_error(state));
+    int entry = target + 1;
+    lua_rawgeti(L, entry, DEFAULTS_NAMES);
+    lua_rawgeti(L, entry, DEFAULTS_ORDINALS);
+    int names = entry + 1,
+        ordinals = entry + 2,
+        size = (int) lua_objlen(L, names);
+    int ancestors[DEFAULTS_COPY_MAX_DEPTH];
+    ancestors[0] = names;
+    for (int i = 0; i < size; i++) {
+        if (present && (present[i >> 6] >> (i & 63)) & 1) {
+            continue;
+        }
+        lua_rawgeti(L, names, i + 1);
+        lua_rawgeti(L, ordinals, i + 1);
+        if (state_is_empty_default(L, -1)) {
+            lua_pop(L, 1);
+            lua_newtable(L);
+        } else if (mode == PB_DEFAULTS_COPY && lua_istable(L, -1)) {
+            state_push_default_copy(L, lua_gettop(L), ancestors, 1);
+            lua_remove(L, -2);
+        }
+        lua_rawset(L, target);
     }
-    lua_getglobal(state->state, "parse");
-    return NULL;
+    lua_pop(L, 3);
 }
 
-pb_error_t *pb_state_parse_descriptor(pb_state_t *state) {
-    int err = lua_pcall(state->state, 1, LUA_MULTRET, 0);
-    if (err) {
-        return pb_error_new(PB_ERR_FAIL, "parse descriptor failed: %s", state_error(state));
-    }
-    return NULL;
+void pb_state_clear_cached_defaults(pb_state_t *state, const void *key) {
+    lua_State *L = state->state;
+    state_push_defaults_cache(L);
+    lua_pushlightuserdata(L, (void *) key);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
 }
 
 void pb_state_register_pb_types(pb_state_t *state) {
@@ -0,0 +1,276 @@
+#ifndef PBLUA_STATE_H
+#define PBLUA_STATE_H
+
+/**
+ * the lua backend of the state functions the codecs call for every value. built with
+ * -DPB_STATE_INLINE='"lua/state.h"', pb.h includes this header in place of their declarations and
+ * they inline into the codecs, otherwise state.c compiles them as the out of line definitions.
+ * the state struct is always defined here, so the binding can keep states on the stack.
+ */
+#include <stdbool.h>
+#include <lua.h>
+#include "../pb/pb.h"
+#include "compat.h"
+
+#ifdef PB_STATE_INLINE
+#define PB_STATE_API static inline
+#else
+#define PB_STATE_API
+#endif
+
+struct pb_state_t {
+    lua_State *state;
+    bool first_key_pushed;
+    // the stack index of the current interned names, 0 if there are none.
+    int names;
+    bool raw;
+};
+
+#if defined(PB_STATE_INLINE) || defined(PBLUA_STATE_IMPL)
+
+PB_STATE_API int pb_state_stack_top(int offset) {
+    return -1 + offset;
+}
+
+PB_STATE_API int pb_state_stack_bottom(int offset) {
+    return 1 + offset;
+}
+
+PB_STATE_API void pb_state_popn(pb_state_t *state, size_t n) {
+    lua_pop(state->state, n);
+}
+
+PB_STATE_API void pb_state_pop(pb_state_t *state) {
+    pb_state_popn(state, 1);
+}
+
+PB_STATE_API bool pb_state_check_stack(pb_state_t *state, size_t n) {
+    return lua_checkstack(state->state, (int) n);
+}
+
+PB_STATE_API int32_t pb_state_get_int32(pb_state_t *state, int sindex) {
+    return (int32_t) lua_tointeger(state->state, sindex);
+}
+
+PB_STATE_API int64_t pb_state_get_int64(pb_state_t *state, int sindex) {
+    return (int64_t) lua_tointeger(state->state, sindex);
+}
+
+PB_STATE_API uint32_t pb_state_get_uint32(pb_state_t *state, int sindex) {
+    return (uint32_t) lua_tounsigned(state->state, sindex);
+}
+
+PB_STATE_API uint64_t pb_state_get_uint64(pb_state_t *state, int sindex) {
+    return (uint64_t) lua_tounsigned(state->state, sindex);
+}
+
+PB_STATE_API float pb_state_get_float(pb_state_t *state, int sindex) {
+    return (float) lua_tonumber(state->state, sindex);
+}
+
+PB_STATE_API double pb_state_get_double(pb_state_t *state, int sindex) {
+    return (double) lua_tonumber(state->state, sindex);
+}
+
+PB_STATE_API bool pb_state_get_bool(pb_state_t *state, int sindex) {
+    return (bool) lua_toboolean(state->state, sindex);
+}
+
+PB_STATE_API pb_string_t pb_state_get_string(pb_state_t *state, int sindex) {
+    pb_string_t str;
+    str.str = lua_tolstring(state->state, sindex, &str.len);
+    return str;
+}
+
+PB_STATE_API size_t pb_state_get_objlen(pb_state_t *state, int sindex) {
+    return lua_objlen(state->state, sindex);
+}
+
+PB_STATE_API pb_statetype_t pb_state_get_type(pb_state_t *state, int sindex) {
+    switch (lua_type(state->state, sindex)) {
+        case LUA_TNIL:
+            return PB_STATE_NIL;
+        case LUA_TNUMBER:
+            return PB_STATE_NUMBER;
+        case LUA_TSTRING:
+            return PB_STATE_STRING;
+        case LUA_TBOOLEAN:
+            return PB_STATE_BOOLEAN;
+        case LUA_TTABLE:
+            return PB_STATE_OBJECT;
+        default:
+            return PB_STATE_OTHER;
+    }
+}
+
+PB_STATE_API bool pb_is_state_type_compatible(pb_statetype_t t, pb_valtype_t v) {
+    switch (t) {
+        case PB_STATE_NUMBER:
+        case PB_STATE_BOOLEAN:
+            return v == PB_VAL_SINT32 ||
+                   v == PB_VAL_SINT64 ||
+                   v == PB_VAL_INT32 ||
+                   v == PB_VAL_INT64 ||
+                   v == PB_VAL_UINT32 ||
+                   v == PB_VAL_UINT64 ||
+                   v == PB_VAL_FIXED32 ||
+                   v == PB_VAL_FIXED64 ||
+                   v == PB_VAL_SFIXED32 ||
+                   v == PB_VAL_SFIXED64 ||
+                   v == PB_VAL_FLOAT ||
+                   v == PB_VAL_DOUBLE ||
+                   v == PB_VAL_BOOL ||
+                   v == PB_VAL_ENUM;
+        case PB_STATE_STRING:
+            return v == PB_VAL_STRING ||
+                   v == PB_VAL_BYTES;
+        case PB_STATE_OBJECT:
+            return v == PB_VAL_MAP ||
+                   v == PB_VAL_MESSAGE ||
+                   v == PB_VAL_ANY;
+        case PB_STATE_NIL:
+        case PB_STATE_OTHER:
+        default:
+            return false;
+    }
+}
+
+PB_STATE_API void pb_state_push_nil(pb_state_t *state) {
+    lua_pushnil(state->state);
+}
+
+PB_STATE_API void pb_state_push_int32(pb_state_t *state, int32_t n) {
+    lua_pushinteger(state->state, (lua_Integer) n);
+}
+
+PB_STATE_API void pb_state_push_int64(pb_state_t *state, int64_t n) {
+    lua_pushinteger(state->state, (lua_Integer) n);
+}
+
+PB_STATE_API void pb_state_push_uint32(pb_state_t *state, uint32_t n) {
+    lua_pushunsigned(state->state, (lua_Unsigned) n);
+}
+
+PB_STATE_API void pb_state_push_uint64(pb_state_t *state, uint64_t n) {
+    lua_pushunsigned(state->state, (lua_Unsigned) n);
+}
+
+PB_STATE_API void pb_state_push_float(pb_state_t *state, float f) {
+    lua_pushnumber(state->state, (lua_Number) f);
+}
+
+PB_STATE_API void pb_state_push_double(pb_state_t *state, double d) {
+    lua_pushnumber(state->state, (lua_Number) d);
+}
+
+PB_STATE_API void pb_state_push_bool(pb_state_t *state, bool b) {
+    lua_pushboolean(state->state, (int) b);
+}
+
+PB_STATE_API void pb_state_push_string(pb_state_t *state, pb_string_t s) {
+    lua_pushlstring(state->state, s.str, s.len);
+}
+
+PB_STATE_API void pb_state_push_array_index(pb_state_t *state, int index) {
+    pb_state_push_int32(state, index + 1);
+}
+
+PB_STATE_API void pb_state_push_map_key(pb_state_t *state, pb_string_t key) {
+    pb_state_push_string(state, key);
+}
+
+PB_STATE_API void pb_state_push_name(pb_state_t *state, size_t index, pb_string_t name) {
+    if (state->names) {
+        lua_rawgeti(state->state, state->names, (int) index + 1);
+    } else {
+        pb_state_push_string(state, name);
+    }
+}
+
+PB_STATE_API void pb_state_push_array(pb_state_t *state) {
+    lua_newtable(state->state);
+}
+
+PB_STATE_API void pb_state_push_map(pb_state_t *state) {
+    lua_newtable(state->state);
+}
+
+PB_STATE_API void pb_state_push_sized_array(pb_state_t *state, size_t narr) {
+    lua_createtable(state->state, (int) narr, 0);
+}
+
+PB_STATE_API void pb_state_push_sized_map(pb_state_t *state, size_t nrec) {
+    lua_createtable(state->state, 0, (int) nrec);
+}
+
+PB_STATE_API void pb_state_set_array_element(pb_state_t *state, size_t index) {
+    // lua is 1-index based.
+    lua_rawseti(state->state, pb_state_stack_top(-1), (int) index + 1);
+}
+
+// the arrays and maps set are the ones being decoded, they have no metamethods.
+PB_STATE_API void pb_state_append_array_element(pb_state_t *state) {
+    lua_rawset(state->state, pb_state_stack_top(-2));
+}
+
+PB_STATE_API void pb_state_set_map_element(pb_state_t *state) {
+    lua_rawset(state->state, pb_state_stack_top(-2));
+}
+
+PB_STATE_API bool pb_state_iter_map_element_pair(pb_state_t *state) {
+    if (!state->first_key_pushed) {
+        state->first_key_pushed = true;
+        lua_pushnil(state->state);
+    }
+    if (!lua_next(state->state, pb_state_stack_top(-1))) {
+        state->first_key_pushed = false;
+        return false;
+    }
+    return true;
+}
+
+static inline bool state_pop_if_nil(pb_state_t *state) {
+    if (lua_isnil(state->state, pb_state_stack_top(0))) {
+        pb_state_pop(state);
+        return false;
+    }
+    return true;
+}
+
+PB_STATE_API void pb_state_set_raw_access(pb_state_t *state, bool raw) {
+    state->raw = raw;
+}
+
+PB_STATE_API bool pb_state_raw_access(pb_state_t *state) {
+    return state->raw;
+}
+
+PB_STATE_API void pb_state_get_array_element(pb_state_t *state, int sindex, int index) {
+    // lua is 1-index based.
+    lua_rawgeti(state->state, sindex, index + 1);
+}
+
+// gets the value of the key at the top from the map at sindex, which is below the key.
+static inline void state_get_map_value(pb_state_t *state, int sindex) {
+    if (state->raw) {
+        lua_rawget(state->state, sindex - 1);
+    } else {
+        lua_gettable(state->state, sindex - 1);
+    }
+}
+
+PB_STATE_API bool pb_state_get_map_element(pb_state_t *state, int sindex, pb_string_t key) {
+    pb_state_push_map_key(state, key);
+    state_get_map_value(state, sindex);
+    return state_pop_if_nil(state);
+}
+
+PB_STATE_API bool pb_state_get_map_element_by_name(pb_state_t *state, int sindex, size_t index, pb_string_t name) {
+    pb_state_push_name(state, index, name);
+    state_get_map_value(state, sindex);
+    return state_pop_if_nil(state);
+}
+
+#endif // PB_STATE_INLINE || PBLUA_STATE_IMPL
+
+#endif // PBLUA_STATE_H
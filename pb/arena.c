@@ -0,0 +1,107 @@
+#include <string.h>
+#include "pb.h"
+#include "common.h"
+
+/**
+ * the arena hands out zeroed memory from blocks it bumps through, so the objects of a schema lie
+ * in the order they are built, a message followed by its fields, and are freed together. strings
+ * are kept once, a field naming a message type shares the name of the message.
+ */
+#define ARENA_ALIGN 8
+#define ARENA_BLOCK_MIN 4096
+#define ARENA_BLOCK_MAX (1 << 20)
+
+struct arena_block_t {
+    struct arena_block_t *next;
+    size_t used;
+    size_t cap;
+    uint8_t data[];
+};
+
+void arena_init(arena_t *arena) {
+    memset(arena, 0, sizeof(arena_t));
+}
+
+static arena_block_t *arena_block_new(arena_t *arena, size_t size) {
+    // blocks double up to a bound, larger objects get a block of their own.
+    size_t cap = arena->blocks ? arena->blocks->cap * 2 : ARENA_BLOCK_MIN;
+    if (cap > ARENA_BLOCK_MAX) {
+        cap = ARENA_BLOCK_MAX;
+    }
+    if (cap < size) {
+        cap = size;
+    }
+    arena_block_t *block = calloc(1, sizeof(arena_block_t) + cap);
+    block->cap = cap;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    arena_block_t *block = arena->blocks;
+    if (!block || block->cap - block->used < size) {
+        block = arena_block_new(arena, size);
+    }
+    void *p = block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+static void arena_strings_insert(pb_string_t *table, size_t cap, pb_string_t s) {
+    size_t i = (size_t) name_hash(s) & (cap - 1);
+    while (table[i].str) {
+        i = (i + 1) & (cap - 1);
+    }
+    table[i] = s;
+}
+
+pb_string_t arena_string(arena_t *arena, pb_string_t s) {
+    if (!s.str) {
+        return s;
+    }
+    uint64_t hash = name_hash(s);
+    if (arena->string_cap) {
+        size_t i = (size_t) hash & (arena->string_cap - 1);
+        while (arena->strings[i].str) {
+            pb_string_t curr = arena->strings[i];
+            if (curr.len == s.len && memcmp(curr.str, s.str, s.len) == 0) {
+                return curr;
+            }
+            i = (i + 1) & (arena->string_cap - 1);
+        }
+    }
+
+    // keep the load factor under 3/4.
+    if ((arena->string_count + 1) * 4 > arena->string_cap * 3) {
+        size_t cap = arena->string_cap ? arena->string_cap * 2 : 256;
+        pb_string_t *table = calloc(cap, sizeof(pb_string_t));
+        for (size_t i = 0; i < arena->string_cap; i++) {
+            if (arena->strings[i].str) {
+                arena_strings_insert(table, cap, arena->strings[i]);
+            }
+        }
+        free(arena->strings);
+        arena->strings = table;
+        arena->string_cap = cap;
+    }
+    // strings are terminated, they are printed in errors.
+    char *p = arena_alloc(arena, s.len + 1);
+    memcpy(p, s.str, s.len);
+    pb_string_t copy = {.str=p, .len=s.len};
+    arena_strings_insert(arena->strings, arena->string_cap, copy);
+    arena->string_count++;
+    return copy;
+}
+
+void arena_free(arena_t *arena) {
+    arena_block_t *block = arena->blocks;
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena->strings);
+    arena_init(arena);
+}
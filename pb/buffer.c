@@ -76,6 +76,24 @@ inline void pb_buffer_readonly(pb_buffer_t *dst, pb_buffer_t *src, size_t size)
     dst->write = size;
 }
 
+inline void pb_buffer_wrap(pb_buffer_t *dst, const uint8_t *payload, size_t size) {
+    dst->payload = (uint8_t *) payload;
+    dst->cap = size;
+    dst->read = 0;
+    dst->write = size;
+}
+
+inline void pb_buffer_reset(pb_buffer_t *buf) {
+    buf->read = 0;
+    buf->write = 0;
+}
+
+inline void pb_buffer_truncate(pb_buffer_t *buf, size_t size) {
+    if (size < pb_buffer_size(buf)) {
+        buf->write = buf->read + size;
+    }
+}
+
 inline void pb_buffer_free(pb_buffer_t *buf) {
     free(buf->payload);
     free(buf);
@@ -136,13 +154,13 @@ inline pb_string_t pb_buffer_payload(pb_buffer_t *buf, size_t len) {
 }
 
 void pb_buffer_grow(pb_buffer_t *buf, size_t min) {
-    size_t size = pb_buffer_size(buf),
-        size_free = buf->cap - size;
-    if (size_free >= min) {
+    // bytes are written after the unread ones, the room before them is only gained by moving.
+    size_t size = pb_buffer_size(buf);
+    if (buf->cap - buf->write >= min) {
         return;
     }
     uint8_t *dst = buf->payload;
-    if (size_free + buf->read < min) {
+    if (buf->cap - size < min) {
         buf->cap = buf->cap * 2 + min;
         dst = malloc(buf->cap * sizeof(uint8_t));
         memcpy(dst, buf->payload + buf->read, size);
@@ -171,6 +189,48 @@ inline uint8_t *pb_buffer_step_write(pb_buffer_t *buf, size_t n) {
     return payload;
 }
 
+inline uint8_t *pb_buffer_reserve(pb_buffer_t *buf, size_t n) {
+    pb_buffer_grow(buf, n);
+    return buf->payload + buf->write;
+}
+
+inline void pb_buffer_commit(pb_buffer_t *buf, size_t n) {
+    buf->write += n;
+}
+
+uint8_t *pb_buffer_reserve_tail(pb_buffer_t *buf, size_t used, size_t n) {
+    if (buf->cap - buf->write - used < n && buf->read) {
+        // the bytes read already make room first.
+        size_t size = pb_buffer_size(buf);
+        memmove(buf->payload, buf->payload + buf->read, size);
+        buf->read = 0;
+        buf->write = size;
+    }
+    if (buf->cap - buf->write - used < n) {
+        // keep the used bytes at the end of the bigger payload.
+        size_t cap = buf->cap * 2 + n;
+        uint8_t *dst = malloc(cap * sizeof(uint8_t));
+        memcpy(dst + buf->read, buf->payload + buf->read, pb_buffer_size(buf));
+        memcpy(dst + cap - used, buf->payload + buf->cap - used, used);
+        free(buf->payload);
+        buf->payload = dst;
+        buf->cap = cap;
+    }
+    return buf->payload + buf->cap - used;
+}
+
+void pb_buffer_commit_tail(pb_buffer_t *buf, size_t used) {
+    if (pb_buffer_size(buf) == 0) {
+        // an empty buffer is read from where the bytes were written, they stay in place.
+        buf->read = buf->cap - used;
+        buf->write = buf->cap;
+        return;
+    }
+    // appended bytes follow the unread ones, they are moved once.
+    memmove(buf->payload + buf->write, buf->payload + buf->cap - used, used);
+    buf->write += used;
+}
+
 size_t pb_buffer_swap_last(pb_buffer_t *buf, size_t prev_n, size_t last_n) {
     if (pb_buffer_size(buf) < prev_n + last_n) {
         return 0;
@@ -1,39 +1,106 @@
 #include "pb.h"
 #include "codec.h"
 
+#if defined(__BMI2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// 0: scalar only, 1: up to SSE2, 2: up to AVX2 with runtime detection.
+#ifndef PB_VARINT_SIMD
+#define PB_VARINT_SIMD 2
+#endif
+
+#if PB_VARINT_SIMD >= 1 && (defined(__SSE2__) || defined(_M_X64))
+#define VARINT_KERNEL_SSE2 1
+#endif
+
+#if PB_VARINT_SIMD >= 2 && defined(__GNUC__) && defined(__x86_64__)
+#define VARINT_KERNEL_AVX2 1
+#endif
+
 #define VARINT_BITCOUNT 7
 #define VARINT_FLAG_MASK (1 << VARINT_BITCOUNT)
 #define VARINT_VALUE_MASK (VARINT_FLAG_MASK - 1)
 
-size_t varint_bytecount(uint64_t n) {
-    size_t c = 0;
-    do {
-        c++;
-        n >>= VARINT_BITCOUNT;
-    } while (n);
+size_t varint_encode(pb_buffer_t *buf, uint64_t n) {
+    size_t c = varint_write(pb_buffer_reserve(buf, VARINT_MAX_BYTECOUNT), n);
+    pb_buffer_commit(buf, c);
     return c;
 }
 
-size_t varint_encode(pb_buffer_t *buf, uint64_t n) {
-    size_t c = varint_bytecount(n);
-    uint8_t *payload = pb_buffer_step_write(buf, c);
-    do {
-        uint8_t b = (uint8_t) (n & VARINT_VALUE_MASK);
-        n >>= VARINT_BITCOUNT;
-        if (n > 0) {
-            b |= VARINT_FLAG_MASK;
+#define VARINT_WORD_FLAG_MASK 0x8080808080808080ULL
+#define VARINT_WORD_VALUE_MASK 0x7f7f7f7f7f7f7f7fULL
+
+// gathers the 7 value bits of each byte in word into a 56 bit integer.
+static inline uint64_t varint_word_pack(uint64_t word) {
+#if defined(__BMI2__)
+    return _pext_u64(word, VARINT_WORD_VALUE_MASK);
+#else
+    word &= VARINT_WORD_VALUE_MASK;
+    word = ((word & 0x7f007f007f007f00ULL) >> 1) | (word & 0x007f007f007f007fULL);
+    word = ((word & 0x3fff00003fff0000ULL) >> 2) | (word & 0x00003fff00003fffULL);
+    word = ((word & 0x0fffffff00000000ULL) >> 4) | (word & 0x000000000fffffffULL);
+    return word;
+#endif
+}
+
+// decodes a varint from p, which must have at least VARINT_MAX_BYTECOUNT bytes readable.
+// returns the byte count, or 0 if the varint overflows 64bit.
+static inline size_t varint_decode_word(const uint8_t *p, uint64_t *n) {
+    uint64_t word = bits_load_le64(p);
+    uint64_t stops = ~word & VARINT_WORD_FLAG_MASK;
+    if (stops) {
+        // the stop bit is the highest bit of the last byte, so this is a multiple of 8.
+        int bits = bits_ctz64(stops) + 1;
+        if (bits < 64) {
+            word &= (1ULL << bits) - 1;
         }
-        *payload++ = b;
-    } while (n);
-    return c;
+        *n = varint_word_pack(word);
+        return (size_t) bits / 8;
+    }
+
+    uint64_t val = varint_word_pack(word);
+    val |= (uint64_t) (p[8] & VARINT_VALUE_MASK) << 56;
+    if (!(p[8] & VARINT_FLAG_MASK)) {
+        *n = val;
+        return 9;
+    }
+    val |= (uint64_t) (p[9] & VARINT_VALUE_MASK) << 63;
+    if (!(p[9] & VARINT_FLAG_MASK)) {
+        *n = val;
+        return 10;
+    }
+    return 0;
 }
 
 pb_error_t *varint_decode(pb_buffer_t *buf, uint64_t *n, size_t *size) {
+    size_t c = pb_buffer_size(buf);
+    if (c > 0) {
+        const uint8_t *p = buf->payload + buf->read;
+        size_t read = 0;
+        if (!(*p & VARINT_FLAG_MASK)) {
+            *n = *p;
+            read = 1;
+        } else if (c >= VARINT_MAX_BYTECOUNT) {
+            read = varint_decode_word(p, n);
+            if (!read) {
+                return pb_error_new(PB_ERR_VARINT, "varint overflow 64bit");
+            }
+        }
+        if (read) {
+            buf->read += read;
+            if (size) {
+                *size += read;
+            }
+            return NULL;
+        }
+    }
+
+    // slow path near the end of buffer.
     uint64_t val = 0;
     uint8_t *p;
     uint8_t b;
     uint8_t shift = 0;
-    size_t c = pb_buffer_size(buf);
     while (shift < 64 && (p = pb_buffer_step_read(buf, 1))) {
         b = *p;
         val += ((uint64_t) b & VARINT_VALUE_MASK) << shift;
@@ -53,15 +120,195 @@ pb_error_t *varint_decode(pb_buffer_t *buf, uint64_t *n, size_t *size) {
     return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
 }
 
-#define BIT32_BYTECOUNT 4
+/**
+ * packed varint runs
+ *
+ * the kernels below work on blocks of 8 (scalar), 16 (SSE2) or 32 (AVX2) bytes: one movemask
+ * gives the continuation bits of the whole block, a block without any is a run of single byte
+ * varints, otherwise every varint terminating inside the block is located with ctz.
+ */
 
-inline size_t bit32_encode(pb_buffer_t *buf, uint32_t n) {
-    uint8_t *payload = pb_buffer_step_write(buf, BIT32_BYTECOUNT);
-    for (int i = 0; i < BIT32_BYTECOUNT; i++) {
-        payload[i] = (uint8_t) (n & 0xff);
-        n >>= 8;
+// bit i is set if byte i has the continuation flag.
+typedef uint32_t (*varint_flags_fn)(const uint8_t *);
+
+static inline uint32_t varint_flags_scalar(const uint8_t *p) {
+    // gathers the top bit of each byte into the top byte.
+    return (uint32_t) (((bits_load_le64(p) & VARINT_WORD_FLAG_MASK) * 0x02040810204081ULL) >> 56);
+}
+
+static inline int bits_popcount32(uint32_t v) {
+#if defined(__GNUC__)
+    return __builtin_popcount(v);
+#else
+    int c = 0;
+    for (; v; v &= v - 1) {
+        c++;
     }
-    return BIT32_BYTECOUNT;
+    return c;
+#endif
+}
+
+// decodes p[0..c), c is 1..VARINT_MAX_BYTECOUNT and only the last byte is a terminator.
+static inline uint64_t varint_decode_span(const uint8_t *p, size_t c, size_t avail) {
+    if (c <= 8 && avail >= 8) {
+        uint64_t word = bits_load_le64(p);
+        if (c < 8) {
+            word &= (1ULL << (c * 8)) - 1;
+        }
+        return varint_word_pack(word);
+    }
+    uint64_t val = 0;
+    for (size_t i = 0; i < c; i++) {
+        val |= (uint64_t) (p[i] & VARINT_VALUE_MASK) << (i * VARINT_BITCOUNT);
+    }
+    return val;
+}
+
+// the byte count of the varint at p, 0 when it is truncated or overflows.
+static inline size_t varint_run_bytecount(const uint8_t *p, size_t len) {
+    size_t c = 0;
+    while (c < len && c < VARINT_MAX_BYTECOUNT && (p[c] & VARINT_FLAG_MASK)) {
+        c++;
+    }
+    return c == len || c == VARINT_MAX_BYTECOUNT ? 0 : c + 1;
+}
+
+static inline size_t varint_decode_run_blocks(const uint8_t *p, size_t len, uint64_t *vals, size_t max,
+                                              size_t *used, const size_t width, varint_flags_fn flags) {
+    const uint32_t block_mask = width == 32 ? UINT32_MAX : (1U << width) - 1;
+    size_t n = 0, off = 0;
+    // keeps 8 readable bytes after each block for the word loads.
+    while (len - off >= width + 8 && n < max) {
+        uint32_t cont = flags(p + off);
+        if (!cont && n + width <= max) {
+            for (size_t i = 0; i < width; i++) {
+                vals[n + i] = p[off + i];
+            }
+            n += width;
+            off += width;
+            continue;
+        }
+        uint32_t stops = ~cont & block_mask;
+        if (!stops) {
+            // no terminator in this block: a long varint, decoded alone before the next block.
+            size_t c = varint_run_bytecount(p + off, len - off);
+            if (!c) {
+                break;
+            }
+            vals[n++] = varint_decode_span(p + off, c, len - off);
+            off += c;
+            continue;
+        }
+        size_t start = off;
+        while (stops && n < max) {
+            size_t stop = off + (size_t) bits_ctz64(stops);
+            size_t c = stop - start + 1;
+            if (c > VARINT_MAX_BYTECOUNT) {
+                *used = start;
+                return n;
+            }
+            vals[n++] = varint_decode_span(p + start, c, len - start);
+            start = stop + 1;
+            stops &= stops - 1;
+        }
+        off = start;
+    }
+
+    while (off < len && n < max) {
+        size_t c = varint_run_bytecount(p + off, len - off);
+        if (!c) {
+            break;
+        }
+        vals[n++] = varint_decode_span(p + off, c, len - off);
+        off += c;
+    }
+    *used = off;
+    return n;
+}
+
+static inline size_t varint_count_blocks(const uint8_t *p, size_t len, const size_t width, varint_flags_fn flags) {
+    size_t c = 0, off = 0;
+    for (; len - off >= width + 8; off += width) {
+        c += width - (size_t) bits_popcount32(flags(p + off));
+    }
+    for (; off < len; off++) {
+        c += !(p[off] & VARINT_FLAG_MASK);
+    }
+    return c;
+}
+
+// the portable kernels are always built, the tests check the SIMD ones against them.
+size_t varint_decode_run_scalar(const uint8_t *p, size_t len, uint64_t *vals, size_t max, size_t *used) {
+    return varint_decode_run_blocks(p, len, vals, max, used, 8, varint_flags_scalar);
+}
+
+size_t varint_count_scalar(const uint8_t *p, size_t len) {
+    return varint_count_blocks(p, len, 8, varint_flags_scalar);
+}
+
+#if VARINT_KERNEL_SSE2
+
+static inline uint32_t varint_flags_sse2(const uint8_t *p) {
+    return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) p));
+}
+
+static size_t varint_decode_run_sse2(const uint8_t *p, size_t len, uint64_t *vals, size_t max, size_t *used) {
+    return varint_decode_run_blocks(p, len, vals, max, used, 16, varint_flags_sse2);
+}
+
+static size_t varint_count_sse2(const uint8_t *p, size_t len) {
+    return varint_count_blocks(p, len, 16, varint_flags_sse2);
+}
+
+#endif
+
+#if VARINT_KERNEL_AVX2
+
+__attribute__((target("avx2")))
+static inline uint32_t varint_flags_avx2(const uint8_t *p) {
+    return (uint32_t) _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *) p));
+}
+
+__attribute__((target("avx2")))
+static size_t varint_decode_run_avx2(const uint8_t *p, size_t len, uint64_t *vals, size_t max, size_t *used) {
+    return varint_decode_run_blocks(p, len, vals, max, used, 32, varint_flags_avx2);
+}
+
+__attribute__((target("avx2")))
+static size_t varint_count_avx2(const uint8_t *p, size_t len) {
+    return varint_count_blocks(p, len, 32, varint_flags_avx2);
+}
+
+#endif
+
+size_t varint_decode_run(const uint8_t *p, size_t len, uint64_t *vals, size_t max, size_t *used) {
+#if VARINT_KERNEL_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return varint_decode_run_avx2(p, len, vals, max, used);
+    }
+#endif
+#if VARINT_KERNEL_SSE2
+    return varint_decode_run_sse2(p, len, vals, max, used);
+#else
+    return varint_decode_run_scalar(p, len, vals, max, used);
+#endif
+}
+
+size_t varint_count(const uint8_t *p, size_t len) {
+#if VARINT_KERNEL_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return varint_count_avx2(p, len);
+    }
+#endif
+#if VARINT_KERNEL_SSE2
+    return varint_count_sse2(p, len);
+#else
+    return varint_count_scalar(p, len);
+#endif
+}
+
+inline size_t bit32_encode(pb_buffer_t *buf, uint32_t n) {
+    return bit32_write(pb_buffer_step_write(buf, BIT32_BYTECOUNT), n);
 }
 
 pb_error_t *bit32_decode(pb_buffer_t *buf, uint32_t *n, size_t *size) {
@@ -69,10 +316,7 @@ pb_error_t *bit32_decode(pb_buffer_t *buf, uint32_t *n, size_t *size) {
     if (!payload) {
         return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
     }
-    uint32_t v = 0;
-    for (int i = 0; i < BIT32_BYTECOUNT; i++) {
-        v += (uint32_t) (payload[i]) << (i * 8);
-    }
+    uint32_t v = bits_load_le32(payload);
     if (size) {
         *size += BIT32_BYTECOUNT;
     }
@@ -80,15 +324,8 @@ pb_error_t *bit32_decode(pb_buffer_t *buf, uint32_t *n, size_t *size) {
     return NULL;
 }
 
-#define BIT64_BYTECOUNT 8
-
 inline size_t bit64_encode(pb_buffer_t *buf, uint64_t n) {
-    uint8_t *payload = pb_buffer_step_write(buf, BIT64_BYTECOUNT);
-    for (int i = 0; i < BIT64_BYTECOUNT; i++) {
-        payload[i] = (uint8_t) (n & 0xff);
-        n >>= 8;
-    }
-    return BIT64_BYTECOUNT;
+    return bit64_write(pb_buffer_step_write(buf, BIT64_BYTECOUNT), n);
 }
 
 pb_error_t *bit64_decode(pb_buffer_t *buf, uint64_t *n, size_t *size) {
@@ -96,10 +333,7 @@ pb_error_t *bit64_decode(pb_buffer_t *buf, uint64_t *n, size_t *size) {
     if (!payload) {
         return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
     }
-    uint64_t v = 0;
-    for (int i = 0; i < BIT64_BYTECOUNT; i++) {
-        v += (uint64_t) (payload[i]) << (i * 8);
-    }
+    uint64_t v = bits_load_le64(payload);
     if (size) {
         *size += BIT64_BYTECOUNT;
     }
@@ -1,12 +1,147 @@
 #ifndef PB_CODEC_H
 #define PB_CODEC_H
 
+#include <string.h>
 #include "pb.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * bits
+ */
+static inline uint64_t bits_load_le64(const uint8_t *p) {
+    uint64_t v;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&v, p, sizeof(v));
+#else
+    v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= (uint64_t) p[i] << (i * 8);
+    }
+#endif
+    return v;
+}
+
+static inline uint32_t bits_load_le32(const uint8_t *p) {
+    uint32_t v;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&v, p, sizeof(v));
+#else
+    v = 0;
+    for (int i = 0; i < 4; i++) {
+        v |= (uint32_t) p[i] << (i * 8);
+    }
+#endif
+    return v;
+}
+
+// v must not be zero.
+static inline int bits_ctz64(uint64_t v) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return (int) i;
+#else
+    int c = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        c++;
+    }
+    return c;
+#endif
+}
+
+// v must not be zero.
+static inline int bits_clz64(uint64_t v) {
+#if defined(__GNUC__)
+    return __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return 63 - (int) i;
+#else
+    int c = 0;
+    while (!(v & (1ULL << 63))) {
+        v <<= 1;
+        c++;
+    }
+    return c;
+#endif
+}
+
+static inline void bits_store_le32(uint8_t *p, uint32_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(p, &v, sizeof(v));
+#else
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t) (v >> (i * 8));
+    }
+#endif
+}
+
+static inline void bits_store_le64(uint8_t *p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(p, &v, sizeof(v));
+#else
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t) (v >> (i * 8));
+    }
+#endif
+}
+
+/**
+ * raw encoders, the caller must reserve enough space: VARINT_MAX_BYTECOUNT for varint,
+ * BIT32_BYTECOUNT and BIT64_BYTECOUNT for fixed width values.
+ */
+#define VARINT_MAX_BYTECOUNT 10
+#define BIT32_BYTECOUNT 4
+#define BIT64_BYTECOUNT 8
+
+static inline size_t varint_bytecount(uint64_t n) {
+    // ceil(bits / 7) without a division: bits * 9 / 64 rounds the same way for 1..64 bits.
+    return (size_t) (((63 - bits_clz64(n | 1)) * 9 + 73) / 64);
+}
+
+static inline size_t varint_write(uint8_t *p, uint64_t n) {
+    uint8_t *start = p;
+    while (n >= 0x80) {
+        *p++ = (uint8_t) (n | 0x80);
+        n >>= 7;
+    }
+    *p++ = (uint8_t) n;
+    return (size_t) (p - start);
+}
+
+static inline size_t bit32_write(uint8_t *p, uint32_t n) {
+    bits_store_le32(p, n);
+    return BIT32_BYTECOUNT;
+}
+
+static inline size_t bit64_write(uint8_t *p, uint64_t n) {
+    bits_store_le64(p, n);
+    return BIT64_BYTECOUNT;
+}
+
 size_t varint_encode(pb_buffer_t *, uint64_t);
 
 pb_error_t *varint_decode(pb_buffer_t *, uint64_t *, size_t *);
 
+// decodes up to max varints of the packed run p[0..len) into vals, *used is set to the bytes consumed.
+// a count below max with bytes left means the run is truncated or has an overflowed varint.
+size_t varint_decode_run(const uint8_t *p, size_t len, uint64_t *vals, size_t max, size_t *used);
+
+// counts the varints terminating in p[0..len).
+size_t varint_count(const uint8_t *p, size_t len);
+
+// the portable kernels of varint_decode_run and varint_count.
+size_t varint_decode_run_scalar(const uint8_t *p, size_t len, uint64_t *vals, size_t max, size_t *used);
+
+size_t varint_count_scalar(const uint8_t *p, size_t len);
+
 size_t bit32_encode(pb_buffer_t *, uint32_t);
 
 pb_error_t *bit32_decode(pb_buffer_t *, uint32_t *, size_t *);
@@ -2,6 +2,7 @@
 #include <printf.h>
 #include "pb.h"
 #include "common.h"
+#include "codec.h"
 
 const char *wire_name(wire_t w) {
     switch (w) {
@@ -54,21 +55,17 @@ wire_t field_wire_type(field_t *field) {
                 case PB_VAL_MAP:
                     return WIRE_REPEATED;
                 case PB_VAL_MESSAGE:
-                    if (field->opts.msg.repeated) {
-                        return WIRE_REPEATED;
-                    }
-                    break;
                 case PB_VAL_STRING:
                 case PB_VAL_BYTES:
-                    if (field->opts.primitive.repeated) {
+                    if (field->repeated) {
                         return WIRE_REPEATED;
                     }
                 default:;
             }
             return field->value_wire;
         default:
-            if (field->opts.primitive.repeated) {
-                if (field->opts.primitive.packed) {
+            if (field->repeated) {
+                if (field->packed) {
                     return WIRE_LENGTH_DELIMITED;
                 }
                 return WIRE_REPEATED;
@@ -77,6 +74,52 @@ wire_t field_wire_type(field_t *field) {
     }
 }
 
+size_t wire_fixed_bytecount(wire_t w) {
+    switch (w) {
+        case WIRE_BIT32:
+            return 4;
+        case WIRE_BIT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+void field_key_init(field_key_t *key, uint64_t tag, wire_t wire) {
+    key->wire = (uint8_t) wire;
+    key->len = (uint8_t) varint_write(key->bytes, tag << HEADER_WIRE_BITCOUNT | (uint64_t) wire);
+}
+
+uint64_t field_number_bits(pb_state_t *s, int sindex, field_t *field) {
+    switch (field->type) {
+        case PB_VAL_SINT32:
+            return (uint32_t) bit32_zigzag(pb_state_get_int32(s, sindex));
+        case PB_VAL_INT32:
+        case PB_VAL_SFIXED32:
+            return (uint32_t) pb_state_get_int32(s, sindex);
+        case PB_VAL_SINT64:
+            return (uint64_t) bit64_zigzag(pb_state_get_int64(s, sindex));
+        case PB_VAL_INT64:
+        case PB_VAL_SFIXED64:
+            return (uint64_t) pb_state_get_int64(s, sindex);
+        case PB_VAL_UINT32:
+        case PB_VAL_FIXED32:
+        case PB_VAL_ENUM:
+            return pb_state_get_uint32(s, sindex);
+        case PB_VAL_UINT64:
+        case PB_VAL_FIXED64:
+            return pb_state_get_uint64(s, sindex);
+        case PB_VAL_FLOAT:
+            return float_to_uint32(pb_state_get_float(s, sindex));
+        case PB_VAL_DOUBLE:
+            return double_to_uint64(pb_state_get_double(s, sindex));
+        case PB_VAL_BOOL:
+            return (uint32_t) pb_state_get_bool(s, sindex);
+        default:
+            return 0;
+    }
+}
+
 static const char *strrchr_n(const char *ptr, char ch, size_t len) {
     for (size_t i = len; i > 0; i--) {
         if (*(ptr + i - 1) == ch) {
@@ -86,61 +129,221 @@ static const char *strrchr_n(const char *ptr, char ch, size_t len) {
     return NULL;
 }
 
+uint64_t name_hash(pb_string_t name) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < name.len; i++) {
+        h ^= (uint8_t) name.str[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void messages_index_insert(rel_t *index, size_t cap, message_t *msg) {
+    size_t i = (size_t) msg->hash & (cap - 1);
+    while (index[i]) {
+        i = (i + 1) & (cap - 1);
+    }
+    rel_set(&index[i], msg);
+}
+
+static void messages_index_add(pb_message_list_t *msgs, message_t *msg) {
+    // keep the load factor under 3/4.
+    if ((msgs->count + 1) * 4 > msgs->index_cap * 3) {
+        // the outgrown index stays in the arena, at most as large as the last one.
+        size_t cap = msgs->index_cap ? msgs->index_cap * 2 : 64;
+        rel_t *index = arena_alloc(&msgs->arena, cap * sizeof(rel_t));
+        for (size_t i = 0; i < msgs->index_cap; i++) {
+            message_t *curr = rel_table_get(&msgs->index, i);
+            if (curr) {
+                messages_index_insert(index, cap, curr);
+            }
+        }
+        rel_set(&msgs->index, index);
+        msgs->index_cap = cap;
+    }
+    messages_index_insert(rel_get(&msgs->index), msgs->index_cap, msg);
+    msgs->count++;
+}
+
 message_t *messages_find(pb_message_list_t *msgs, pb_string_t name) {
+    // type urls of any values are looked up by the name after the last '/'.
     const char *ptr = strrchr_n(name.str, '/', name.len);
     if (ptr) {
+        ptr++;
         name.len -= (ptr - name.str);
         name.str = ptr;
     }
-    message_t *curr = msgs->first;
-    while (curr) {
-        size_t max;
-        if (name.len > curr->name.len) {
-            max = name.len;
-        } else {
-            max = curr->name.len;
-        }
-        if (strncmp(curr->name.str, name.str, max) == 0) {
+    if (!msgs->index_cap) {
+        return NULL;
+    }
+    uint64_t hash = name_hash(name);
+    size_t i = (size_t) hash & (msgs->index_cap - 1);
+    message_t *curr;
+    while ((curr = rel_table_get(&msgs->index, i))) {
+        if (curr->hash == hash && curr->name.len == name.len &&
+            memcmp(rel_get(&curr->name.str), name.str, name.len) == 0) {
             return curr;
         }
-        curr = curr->next;
+        i = (i + 1) & (msgs->index_cap - 1);
     }
     return NULL;
 }
 
-field_t *message_find_field_by_tag(message_t *msg, field_t *prev, uint64_t tag) {
-    if (!prev) {
-        prev = msg->first;
+static void field_link(pb_message_list_t *msgs, field_t *field) {
+    if (field->type == PB_VAL_MESSAGE) {
+        rel_set(&field->msg, messages_find(msgs, field_msg_name(field)));
     }
-    field_t *curr = prev;
-    while (curr) {
-        if (curr->tag == tag) {
-            return curr;
+    if (field_array_element(field)) {
+        field_link(msgs, field_array_element(field));
+    }
+    if (field_map_val(field)) {
+        field_link(msgs, field_map_val(field));
+    }
+}
+
+static int field_tag_compare(const void *a, const void *b) {
+    uint64_t ta = (*(field_t *const *) a)->tag,
+        tb = (*(field_t *const *) b)->tag;
+    return ta < tb ? -1 : ta > tb;
+}
+
+// tags up to this bound are always indexed directly, above it only if at least half of the slots are used.
+#define MESSAGE_DENSE_TAG_MAX 64
+
+static pb_error_t *message_compile(pb_message_list_t *msgs, message_t *msg) {
+    size_t count = 0;
+    for (field_t *field = message_first(msg); field; field = field_next(field)) {
+        count++;
+    }
+    field_t **sorted = malloc((count ? count : 1) * sizeof(field_t *));
+    count = 0;
+    for (field_t *field = message_first(msg); field; field = field_next(field)) {
+        sorted[count++] = field;
+    }
+    qsort(sorted, count, sizeof(field_t *), field_tag_compare);
+
+    // compiling again replaces the previous tables.
+    rel_t *fields = arena_alloc(&msgs->arena, (count ? count : 1) * sizeof(rel_t));
+    rel_set(&msg->fields, fields);
+    msg->field_count = count;
+    rel_set(&msg->by_tag, NULL);
+    msg->by_tag_len = 0;
+
+    // relink in tag order, so walking the list and the table agree.
+    rel_set(&msg->first, count ? sorted[0] : NULL);
+    rel_set(&msg->last, count ? sorted[count - 1] : NULL);
+    pb_error_t *err = NULL;
+    for (size_t i = 0; i < count; i++) {
+        field_t *field = sorted[i];
+        rel_set(&fields[i], field);
+        field->ordinal = i;
+        rel_set(&field->next, i + 1 < count ? sorted[i + 1] : NULL);
+        if (!err && i + 1 < count && sorted[i + 1]->tag == field->tag) {
+            pb_string_t name = message_name(msg),
+                next_name = field_name(sorted[i + 1]);
+            err = pb_error_new(
+                PB_ERR_FAIL,
+                "duplicate field tag: %.*s, %.*s, %d",
+                (int) name.len, name.str,
+                (int) next_name.len, next_name.str,
+                (int) field->tag
+            );
         }
-        curr = curr->next;
     }
-    curr = msg->first;
-    while (curr && curr != prev) {
-        if (curr->tag == tag) {
-            return curr;
+
+    uint64_t max = count ? sorted[count - 1]->tag : 0;
+    if (!err && count && (max <= MESSAGE_DENSE_TAG_MAX || max <= count * 2)) {
+        msg->by_tag_len = (size_t) max + 1;
+        rel_t *by_tag = arena_alloc(&msgs->arena, msg->by_tag_len * sizeof(rel_t));
+        for (size_t i = 0; i < count; i++) {
+            rel_set(&by_tag[sorted[i]->tag], sorted[i]);
+        }
+        rel_set(&msg->by_tag, by_tag);
+    }
+    free(sorted);
+    return err;
+}
+
+pb_error_t *messages_link(pb_message_list_t *msgs) {
+    pb_error_t *err = NULL;
+    size_t names = MESSAGES_NAME_ANY_VALUE + 1;
+    for (message_t *msg = messages_first(msgs); msg && !err; msg = message_next(msg)) {
+        err = message_compile(msgs, msg);
+        for (size_t i = 0; i < msg->field_count && !err; i++) {
+            field_t *field = message_field(msg, i);
+            field_link(msgs, field);
+            field->name_index = names++;
+        }
+    }
+    msgs->name_count = names;
+    return err;
+}
+
+void messages_use_names(pb_message_list_t *msgs, pb_state_t *s) {
+    if (!pb_state_use_names(s, msgs, msgs->name_count)) {
+        return;
+    }
+    pb_state_add_name(s, MESSAGES_NAME_ANY_TYPE, rel_string(&msgs->any_type_field));
+    pb_state_add_name(s, MESSAGES_NAME_ANY_VALUE, rel_string(&msgs->any_value_field));
+    for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg)) {
+        for (size_t i = 0; i < msg->field_count; i++) {
+            field_t *field = message_field(msg, i);
+            pb_state_add_name(s, field->name_index, field_name(field));
+        }
+    }
+}
+
+field_t *message_find_field_by_tag(message_t *msg, uint64_t tag) {
+    if (msg->by_tag_len) {
+        return tag < msg->by_tag_len ? rel_table_get(&msg->by_tag, (size_t) tag) : NULL;
+    }
+    size_t lo = 0,
+        hi = msg->field_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        field_t *field = message_field(msg, mid);
+        if (field->tag == tag) {
+            return field;
+        }
+        if (field->tag < tag) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
-        curr = curr->next;
     }
     return NULL;
 }
 
-static void field_init(field_t *field, pb_string_t name, uint64_t tag, pb_valtype_t type, field_opts_t opts) {
-    field->name = name;
+static void field_init(pb_message_list_t *msgs, field_t *field, pb_string_t name, uint64_t tag, pb_valtype_t type, field_opts_t opts) {
+    rel_string_set(&field->name, arena_string(&msgs->arena, name));
     field->tag = tag;
     field->type = type;
-    field->opts = opts;
+    switch (type) {
+        case PB_VAL_MAP:
+            field->map_key_type = opts.map.key_type;
+            field->map_value_type = opts.map.value_type;
+            rel_string_set(&field->msg_name, arena_string(&msgs->arena, opts.map.value_message_name));
+            break;
+        case PB_VAL_ANY:
+        case PB_VAL_MESSAGE:
+            field->repeated = opts.msg.repeated;
+            rel_string_set(&field->msg_name, arena_string(&msgs->arena, opts.msg.name));
+            break;
+        default:
+            field->repeated = opts.primitive.repeated;
+            field->packed = opts.primitive.packed;
+            break;
+    }
 
     field->value_wire = value_wire_type(field->type);
     field->field_wire = field_wire_type(field);
+    field_key_init(&field->value_key, tag, field->value_wire);
+    field_key_init(&field->packed_key, tag, WIRE_LENGTH_DELIMITED);
 
     switch (field->type) {
         case PB_VAL_MAP:
-            switch (field->opts.map.value_type) {
+            switch (field->map_value_type) {
                 case PB_VAL_MAP:
                 case PB_VAL_ANY:
                 case PB_VAL_MESSAGE:
@@ -150,108 +353,76 @@ static void field_init(field_t *field, pb_string_t name, uint64_t tag, pb_valtyp
                     opts = field_opts_primitive(false, false);
                     break;
             }
-            field->map_val = field_new(
+            rel_set(&field->map_val, field_new(
+                msgs,
                 string_new(""),
                 PB_MAP_VAL_TAG,
-                field->opts.map.value_type,
+                field->map_value_type,
                 opts
-            );
-            field->map_key = field_new(
+            ));
+            rel_set(&field->map_key, field_new(
+                msgs,
                 string_new(""),
                 PB_MAP_KEY_TAG,
-                field->opts.map.key_type,
+                field->map_key_type,
                 field_opts_primitive(false, false)
-            );
+            ));
+            break;
         case PB_VAL_ANY:
         case PB_VAL_MESSAGE:
             // custom message
-            if (field->opts.msg.repeated) {
-                field->array_element = field_new(
-                    string_copy(field->opts.msg.name),
+            if (field->repeated) {
+                rel_set(&field->array_element, field_new(
+                    msgs,
+                    field_msg_name(field),
                     field->tag,
                     field->type,
-                    field_opts_msg(false, field->opts.msg.name)
-                );
+                    field_opts_msg(false, field_msg_name(field))
+                ));
             }
             break;
         default:
             // primitive
-            if (field->opts.primitive.repeated) {
-                field->array_element = field_new(
-                    string_copy(field->opts.msg.name),
+            if (field->repeated) {
+                rel_set(&field->array_element, field_new(
+                    msgs,
+                    string_new(""),
                     field->tag,
                     field->type,
                     field_opts_primitive(false, false)
-                );
+                ));
             }
             break;
     }
 }
 
-field_t *field_new(pb_string_t name, uint64_t tag, pb_valtype_t type, field_opts_t opts) {
-    field_t *field = calloc(1, sizeof(field_t));
-    field_init(field, string_copy(name), tag, type, opts);
+field_t *field_new(pb_message_list_t *msgs, pb_string_t name, uint64_t tag, pb_valtype_t type, field_opts_t opts) {
+    field_t *field = arena_alloc(&msgs->arena, sizeof(field_t));
+    field_init(msgs, field, name, tag, type, opts);
     return field;
 }
 
-void field_free(field_t *field) {
-    if (field->array_element) {
-        field_free(field->array_element);
-    }
-    if (field->map_key) {
-        field_free(field->map_key);
-    }
-    if (field->map_val) {
-        field_free(field->map_val);
-    }
-    free(field);
-}
-
-message_t *message_new(pb_string_t name) {
-    message_t *msg = calloc(1, sizeof(message_t));
-    msg->name = string_copy(name);
+message_t *message_new(pb_message_list_t *msgs, pb_string_t name) {
+    message_t *msg = arena_alloc(&msgs->arena, sizeof(message_t));
+    rel_string_set(&msg->name, arena_string(&msgs->arena, name));
+    msg->hash = name_hash(name);
     return msg;
 }
 
-static void message_free(message_t *msg) {
-    field_t *field = msg->first,
-        *field_tmp;
-    while (field) {
-        field_tmp = field->next;
-        switch (field->type) {
-            case PB_VAL_MAP:
-                string_free_copy(field->opts.map.value_message_name);
-                break;
-            case PB_VAL_MESSAGE:
-                string_free_copy(field->opts.msg.name);
-                break;
-            default:;
-        }
-        string_free_copy(field->name);
-        field_free(field);
-        field = field_tmp;
-    }
-
-    message_t *msg_tmp;
-    while (msg) {
-        msg_tmp = msg->next;
-        string_free_copy(msg->name);
-        msg = msg_tmp;
-    }
-}
-
 pb_message_list_t *messages_new() {
-    pb_message_list_t *msgs = calloc(1, sizeof(pb_message_list_t));
-    msgs->any_type_field = string_new("type");
-    msgs->any_value_field = string_new("value");
+    // the list lives in its own arena, the arena is moved into it.
+    arena_t arena;
+    arena_init(&arena);
+    pb_message_list_t *msgs = arena_alloc(&arena, sizeof(pb_message_list_t));
+    msgs->arena = arena;
+    rel_string_set(&msgs->any_type_field, arena_string(&msgs->arena, string_new("type")));
+    rel_string_set(&msgs->any_value_field, arena_string(&msgs->arena, string_new("value")));
     return msgs;
 }
 
 void messages_free(pb_message_list_t *msgs) {
-    if (msgs->first) {
-        message_free(msgs->first);
-    }
-    free(msgs);
+    arena_t arena = msgs->arena;
+    arena_free(&arena);
 }
 
 field_opts_t field_opts_nop() {
@@ -263,21 +434,17 @@ field_opts_t field_opts_map(pb_valtype_t key_type, pb_valtype_t value_type, pb_s
     field_opts_t opts = {};
     opts.map.key_type = key_type;
     opts.map.value_type = value_type;
-    opts.map.value_message_name = string_copy(val_msg_name);
+    opts.map.value_message_name = val_msg_name;
     return opts;
 }
 
-static field_opts_t field_opts_msg_no_copy(bool repeated, pb_string_t msg_name) {
+field_opts_t field_opts_msg(bool repeated, pb_string_t msg_name) {
     field_opts_t opts = {};
     opts.msg.repeated = repeated;
     opts.msg.name = msg_name;
     return opts;
 }
 
-field_opts_t field_opts_msg(bool repeated, pb_string_t msg_name) {
-    return field_opts_msg_no_copy(repeated, string_copy(msg_name));
-}
-
 field_opts_t field_opts_primitive(bool repeated, bool packed) {
     field_opts_t opts = {};
     opts.primitive.repeated = repeated;
@@ -286,45 +453,24 @@ field_opts_t field_opts_primitive(bool repeated, bool packed) {
 }
 
 void messages_append_msg(pb_message_list_t *msgs, message_t *msg) {
-    if (!msgs->first) {
-        msgs->first = msg;
-        return;
-    }
-    message_t *parent = msgs->first;
-    while (parent->next) {
-        parent = parent->next;
+    if (!messages_first(msgs)) {
+        rel_set(&msgs->first, msg);
+    } else {
+        message_t *last = rel_get(&msgs->last);
+        rel_set(&last->next, msg);
     }
-    parent->next = msg;
+    rel_set(&msgs->last, msg);
+    messages_index_add(msgs, msg);
 }
 
 pb_error_t *message_append_field(message_t *msg, field_t *field) {
-    field_t *prev = NULL,
-        *curr = msg->first;
-    if (!curr) {
-        msg->first = field;
-        return NULL;
-    }
-    while (curr) {
-        if (curr->tag == field->tag) {
-            return pb_error_new(
-                PB_ERR_FAIL,
-                "duplicate field tag: %s, %s, %d",
-                msg->name.str,
-                field->name.str,
-                field->tag
-            );
-        }
-        if (curr->tag > field->tag) {
-            break;
-        }
-        prev = curr;
-        curr = curr->next;
-    }
-    field->next = curr;
-    if (!prev) {
-        msg->first = field;
+    // fields are sorted and checked for duplicate tags by messages_link.
+    if (!message_first(msg)) {
+        rel_set(&msg->first, field);
     } else {
-        prev->next = field;
+        field_t *last = rel_get(&msg->last);
+        rel_set(&last->next, field);
     }
+    rel_set(&msg->last, field);
     return NULL;
 }
@@ -2,6 +2,7 @@
 #define PB_COMMON_H
 
 #include "stdbool.h"
+#include <stdint.h>
 #include "pb.h"
 
 #define HEADER_WIRE_BITCOUNT  3
@@ -16,12 +17,65 @@ typedef enum {
     WIRE_REPEATED = 255
 } wire_t;
 
+// the longest key is a varint of (tag << 3 | wire).
+#define FIELD_KEY_MAX_BYTECOUNT 10
+
+// the state values one level of message nesting holds at most while encoding or decoding, the
+// levels recurse with the data, so each one makes sure of its own.
+#define MESSAGE_STACK_SLOTS 8
+
+// a field key encoded once at schema load.
+typedef struct {
+    uint8_t len;
+    uint8_t wire;
+    uint8_t bytes[FIELD_KEY_MAX_BYTECOUNT];
+} field_key_t;
+
 typedef struct {
     uint64_t tag;
     uint8_t wire;
     uint64_t len;
+
+    // if set, written instead of encoding tag and wire.
+    const field_key_t *key;
 } header_t;
 
+/**
+ * schema objects refer to each other by offsets from the referring member instead of pointers, so
+ * a compiled schema is used in place wherever it is mapped. an offset of 0 is NULL. schema objects
+ * are never copied by value, the offsets would then point elsewhere.
+ */
+typedef int64_t rel_t;
+
+static inline void *rel_get(const rel_t *r) {
+    return *r ? (void *) ((uintptr_t) r + (uintptr_t) *r) : NULL;
+}
+
+static inline void rel_set(rel_t *r, const void *p) {
+    *r = p ? (rel_t) ((uintptr_t) p - (uintptr_t) r) : 0;
+}
+
+typedef struct {
+    rel_t str;
+    size_t len;
+} rel_string_t;
+
+static inline pb_string_t rel_string(const rel_string_t *r) {
+    pb_string_t s = {.str=(const char *) rel_get(&r->str), .len=r->len};
+    return s;
+}
+
+static inline void rel_string_set(rel_string_t *r, pb_string_t s) {
+    rel_set(&r->str, s.str);
+    r->len = s.len;
+}
+
+// the element at i of a table of offsets.
+static inline void *rel_table_get(const rel_t *table, size_t i) {
+    return rel_get((const rel_t *) rel_get(table) + i);
+}
+
+// the options a field is built with.
 typedef union {
     struct {
         pb_valtype_t key_type;
@@ -40,46 +94,171 @@ typedef union {
 
 typedef struct field_t field_t;
 struct field_t {
-    pb_string_t name;
+    rel_string_t name;
     uint64_t tag;
 
     pb_valtype_t type;
     wire_t value_wire;
-    field_opts_t opts;
     wire_t field_wire;
+    bool repeated;
+    bool packed;
+    pb_valtype_t map_key_type;
+    pb_valtype_t map_value_type;
+    // the message of a message field or a map value by name, resolved to msg by messages_link.
+    rel_string_t msg_name;
+
+    field_key_t value_key;
+    field_key_t packed_key;
 
-    field_t *array_element;
-    field_t *map_key;
-    field_t *map_val;
+    // field_t
+    rel_t array_element;
+    rel_t map_key;
+    rel_t map_val;
 
-    field_t *next;
+    // message_t, the message of a message field, resolved by messages_link.
+    rel_t msg;
+    // the position in the fields of the message, set by messages_link.
+    size_t ordinal;
+    // the index of the interned name, set by messages_link.
+    size_t name_index;
+
+    // field_t
+    rel_t next;
 };
 
+typedef struct arena_block_t arena_block_t;
+
+// hands out the memory of a built schema, which is freed at once.
+typedef struct {
+    arena_block_t *blocks;
+    // the strings kept so far, open addressing by hash, the capacity is a power of two.
+    pb_string_t *strings;
+    size_t string_cap;
+    size_t string_count;
+} arena_t;
+
+void arena_init(arena_t *arena);
+
+// zeroed memory aligned to 8 bytes.
+void *arena_alloc(arena_t *arena, size_t size);
+
+// a terminated copy of s, the same string is copied once.
+pb_string_t arena_string(arena_t *arena, pb_string_t s);
+
+void arena_free(arena_t *arena);
+
 typedef struct message_t {
-    pb_string_t name;
-    field_t *first;
+    rel_string_t name;
+    uint64_t hash;
+    // field_t
+    rel_t first;
+    rel_t last;
 
-    struct message_t *next;
+    // compiled by messages_link: the fields sorted by tag, and a table indexed by tag when the
+    // tags are dense enough, otherwise fields are found by binary search. both are tables of
+    // offsets to field_t.
+    rel_t fields;
+    size_t field_count;
+    rel_t by_tag;
+    size_t by_tag_len;
+
+    // message_t
+    rel_t next;
 } message_t;
 
 struct pb_message_list_t {
-    message_t *first;
+    // message_t
+    rel_t first;
+    rel_t last;
+
+    // open addressing index by full name, a table of offsets to message_t. the capacity is a
+    // power of two.
+    rel_t index;
+    size_t index_cap;
+    size_t count;
+
+    rel_string_t any_type_field;
+    rel_string_t any_value_field;
 
-    pb_string_t any_type_field;
-    pb_string_t any_value_field;
+    // the number of interned names: the any keys, then the field names of every message.
+    size_t name_count;
+
+    // the list and everything in it are allocated from the arena, unused by compiled schemas.
+    arena_t arena;
 };
 
+static inline field_t *field_array_element(const field_t *field) {
+    return (field_t *) rel_get(&field->array_element);
+}
+
+static inline field_t *field_map_key(const field_t *field) {
+    return (field_t *) rel_get(&field->map_key);
+}
+
+static inline field_t *field_map_val(const field_t *field) {
+    return (field_t *) rel_get(&field->map_val);
+}
+
+static inline struct message_t *field_msg(const field_t *field) {
+    return (struct message_t *) rel_get(&field->msg);
+}
+
+static inline field_t *field_next(const field_t *field) {
+    return (field_t *) rel_get(&field->next);
+}
+
+static inline pb_string_t field_name(const field_t *field) {
+    return rel_string(&field->name);
+}
+
+static inline pb_string_t field_msg_name(const field_t *field) {
+    return rel_string(&field->msg_name);
+}
+
+static inline field_t *message_first(const message_t *msg) {
+    return (field_t *) rel_get(&msg->first);
+}
+
+// the field at ordinal i.
+static inline field_t *message_field(const message_t *msg, size_t i) {
+    return (field_t *) rel_table_get(&msg->fields, i);
+}
+
+static inline message_t *message_next(const message_t *msg) {
+    return (message_t *) rel_get(&msg->next);
+}
+
+static inline pb_string_t message_name(const message_t *msg) {
+    return rel_string(&msg->name);
+}
+
+static inline message_t *messages_first(const pb_message_list_t *msgs) {
+    return (message_t *) rel_get(&msgs->first);
+}
+
+#define MESSAGES_NAME_ANY_TYPE 0
+#define MESSAGES_NAME_ANY_VALUE 1
+
 const char *wire_name(wire_t w);
 
 wire_t value_wire_type(pb_valtype_t);
 
 wire_t field_wire_type(field_t *);
 
+size_t wire_fixed_bytecount(wire_t w);
+
+void field_key_init(field_key_t *key, uint64_t tag, wire_t wire);
+
+// the number at sindex as it goes on the wire: zigzag applied, floats as their bits.
+uint64_t field_number_bits(pb_state_t *s, int sindex, field_t *field);
+
+uint64_t name_hash(pb_string_t name);
+
 pb_message_list_t *messages_new();
 
 void messages_free(pb_message_list_t *msgs);
 
-message_t *message_new(pb_string_t);
+message_t *message_new(pb_message_list_t *msgs, pb_string_t name);
 
 field_opts_t field_opts_nop();
 
@@ -89,7 +268,8 @@ field_opts_t field_opts_msg(bool repeated, pb_string_t msg_name);
 
 field_opts_t field_opts_primitive(bool repeated, bool packed);
 
-field_t *field_new(pb_string_t name, uint64_t tag, pb_valtype_t type, field_opts_t opts);
+// a field allocated with the schema of msgs, it is freed with msgs.
+field_t *field_new(pb_message_list_t *msgs, pb_string_t name, uint64_t tag, pb_valtype_t type, field_opts_t opts);
 
 void messages_append_msg(pb_message_list_t *, message_t *);
 
@@ -97,6 +277,13 @@ pb_error_t *message_append_field(message_t *msg, field_t *field);
 
 message_t *messages_find(pb_message_list_t *, pb_string_t name);
 
-field_t *message_find_field_by_tag(message_t *msg, field_t *prev, uint64_t tag);
+// compiles the field tables of every message and resolves the message of every message field,
+// so encoding and decoding never look up names.
+pb_error_t *messages_link(pb_message_list_t *msgs);
+
+field_t *message_find_field_by_tag(message_t *msg, uint64_t tag);
+
+// makes the interned names of msgs current in s, interning them the first time.
+void messages_use_names(pb_message_list_t *msgs, pb_state_t *s);
 
 #endif // PB_COMMON_H
\ No newline at end of file
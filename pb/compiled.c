@@ -0,0 +1,401 @@
+#include <string.h>
+#include "pb.h"
+#include "common.h"
+
+/**
+ * a compiled schema is the linked schema written out as one flat image: a header, the list, the
+ * messages, the fields, the tables of offsets and the strings. the schema objects refer to each
+ * other by offsets, so the image is used in place wherever it is mapped, and processes mapping the
+ * same file share its pages.
+ *
+ * the image has the layout of the build that wrote it, a build of another layout rejects it. every
+ * offset in it is checked once when it is mapped, so a damaged image is rejected instead of read out
+ * of bounds. the values besides the offsets are trusted.
+ */
+#define COMPILED_MAGIC "PBLC"
+#define COMPILED_VERSION 1
+#define COMPILED_BYTE_ORDER 0x01020304u
+#define COMPILED_ALIGN 8
+// fields nest at most as a map value of a message, deeper nesting is damage.
+#define COMPILED_FIELD_DEPTH 4
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    // the layout the image was written with.
+    uint32_t byte_order;
+    uint32_t size_of_size;
+    uint32_t size_of_list;
+    uint32_t size_of_message;
+    uint32_t size_of_field;
+    // the size of the whole image.
+    uint64_t size;
+} compiled_header_t;
+
+typedef struct {
+    const message_t *src;
+    message_t *dst;
+} compiled_msg_t;
+
+typedef struct {
+    uint8_t *base;
+    // where the next fields, tables and strings are written.
+    size_t fields;
+    size_t tables;
+    size_t strings;
+
+    // the messages of the source sorted by address, with their copies.
+    compiled_msg_t *msgs;
+    size_t msg_count;
+} compiler_t;
+
+static void compiled_header_init(compiled_header_t *h, size_t size) {
+    memcpy(h->magic, COMPILED_MAGIC, sizeof(h->magic));
+    h->version = COMPILED_VERSION;
+    h->byte_order = COMPILED_BYTE_ORDER;
+    h->size_of_size = sizeof(size_t);
+    h->size_of_list = sizeof(pb_message_list_t);
+    h->size_of_message = sizeof(message_t);
+    h->size_of_field = sizeof(field_t);
+    h->size = size;
+}
+
+static bool compiled_header_matches(const compiled_header_t *h) {
+    return h->version == COMPILED_VERSION &&
+           h->byte_order == COMPILED_BYTE_ORDER &&
+           h->size_of_size == sizeof(size_t) &&
+           h->size_of_list == sizeof(pb_message_list_t) &&
+           h->size_of_message == sizeof(message_t) &&
+           h->size_of_field == sizeof(field_t);
+}
+
+static inline size_t compiled_align(size_t n) {
+    return (n + COMPILED_ALIGN - 1) & ~(size_t) (COMPILED_ALIGN - 1);
+}
+
+static size_t compiled_string_size(pb_string_t s) {
+    return s.str ? s.len + 1 : 0;
+}
+
+// the number of fields under field, itself included, and the bytes of their strings.
+static size_t compiled_field_count(const field_t *field, size_t *strings) {
+    if (!field) {
+        return 0;
+    }
+    *strings += compiled_string_size(field_name(field)) + compiled_string_size(field_msg_name(field));
+    return 1 + compiled_field_count(field_array_element(field), strings) +
+           compiled_field_count(field_map_key(field), strings) +
+           compiled_field_count(field_map_val(field), strings);
+}
+
+static void *compiler_alloc(compiler_t *c, size_t *cursor, size_t size) {
+    void *p = c->base + *cursor;
+    *cursor += size;
+    return p;
+}
+
+// strings are terminated, they are printed in errors.
+static void compiler_string(compiler_t *c, rel_string_t *dst, pb_string_t s) {
+    if (!s.str) {
+        rel_set(&dst->str, NULL);
+        dst->len = 0;
+        return;
+    }
+    char *p = compiler_alloc(c, &c->strings, s.len + 1);
+    memcpy(p, s.str, s.len);
+    p[s.len] = '\0';
+    rel_set(&dst->str, p);
+    dst->len = s.len;
+}
+
+static int compiled_msg_compare(const void *a, const void *b) {
+    uintptr_t pa = (uintptr_t) ((const compiled_msg_t *) a)->src,
+        pb = (uintptr_t) ((const compiled_msg_t *) b)->src;
+    return pa < pb ? -1 : pa > pb;
+}
+
+static message_t *compiler_find_msg(compiler_t *c, const message_t *src) {
+    if (!src) {
+        return NULL;
+    }
+    compiled_msg_t key = {.src=src};
+    compiled_msg_t *found = bsearch(&key, c->msgs, c->msg_count, sizeof(compiled_msg_t), compiled_msg_compare);
+    return found ? found->dst : NULL;
+}
+
+static field_t *compiler_field_new(compiler_t *c, const field_t *src);
+
+static void compiler_copy_field(compiler_t *c, field_t *dst, const field_t *src) {
+    dst->tag = src->tag;
+    dst->type = src->type;
+    dst->value_wire = src->value_wire;
+    dst->field_wire = src->field_wire;
+    dst->repeated = src->repeated;
+    dst->packed = src->packed;
+    dst->map_key_type = src->map_key_type;
+    dst->map_value_type = src->map_value_type;
+    dst->value_key = src->value_key;
+    dst->packed_key = src->packed_key;
+    dst->ordinal = src->ordinal;
+    dst->name_index = src->name_index;
+    compiler_string(c, &dst->name, field_name(src));
+    compiler_string(c, &dst->msg_name, field_msg_name(src));
+    rel_set(&dst->array_element, compiler_field_new(c, field_array_element(src)));
+    rel_set(&dst->map_key, compiler_field_new(c, field_map_key(src)));
+    rel_set(&dst->map_val, compiler_field_new(c, field_map_val(src)));
+    rel_set(&dst->msg, compiler_find_msg(c, field_msg(src)));
+}
+
+static field_t *compiler_field_new(compiler_t *c, const field_t *src) {
+    if (!src) {
+        return NULL;
+    }
+    field_t *dst = compiler_alloc(c, &c->fields, sizeof(field_t));
+    compiler_copy_field(c, dst, src);
+    return dst;
+}
+
+static void compiler_copy_message(compiler_t *c, message_t *dst, const message_t *src) {
+    compiler_string(c, &dst->name, message_name(src));
+    dst->hash = src->hash;
+    dst->field_count = src->field_count;
+    dst->by_tag_len = src->by_tag_len;
+
+    // the fields of a message are kept together in tag order, their children follow them.
+    field_t *fields = compiler_alloc(c, &c->fields, src->field_count * sizeof(field_t));
+    rel_t *table = compiler_alloc(c, &c->tables, src->field_count * sizeof(rel_t));
+    for (size_t i = 0; i < src->field_count; i++) {
+        compiler_copy_field(c, &fields[i], message_field(src, i));
+        rel_set(&table[i], &fields[i]);
+        rel_set(&fields[i].next, i + 1 < src->field_count ? &fields[i + 1] : NULL);
+    }
+    rel_set(&dst->fields, table);
+    rel_set(&dst->first, src->field_count ? &fields[0] : NULL);
+    rel_set(&dst->last, src->field_count ? &fields[src->field_count - 1] : NULL);
+
+    if (src->by_tag_len) {
+        rel_t *by_tag = compiler_alloc(c, &c->tables, src->by_tag_len * sizeof(rel_t));
+        for (size_t i = 0; i < src->by_tag_len; i++) {
+            field_t *field = rel_table_get(&src->by_tag, i);
+            rel_set(&by_tag[i], field ? &fields[field->ordinal] : NULL);
+        }
+        rel_set(&dst->by_tag, by_tag);
+    }
+}
+
+pb_error_t *pb_messages_compile(pb_message_list_t *msgs, pb_buffer_t *buf) {
+    // sized first, so the image is written into one block.
+    size_t msg_count = 0,
+        field_count = 0,
+        table_count = msgs->index_cap,
+        string_size = compiled_string_size(rel_string(&msgs->any_type_field)) +
+                      compiled_string_size(rel_string(&msgs->any_value_field));
+    for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg)) {
+        msg_count++;
+        table_count += msg->field_count + msg->by_tag_len;
+        string_size += compiled_string_size(message_name(msg));
+        for (size_t i = 0; i < msg->field_count; i++) {
+            field_count += compiled_field_count(message_field(msg, i), &string_size);
+        }
+    }
+
+    size_t list_off = sizeof(compiled_header_t),
+        msgs_off = list_off + sizeof(pb_message_list_t),
+        fields_off = msgs_off + msg_count * sizeof(message_t),
+        tables_off = fields_off + field_count * sizeof(field_t),
+        strings_off = tables_off + table_count * sizeof(rel_t),
+        size = compiled_align(strings_off + string_size);
+
+    compiler_t c = {
+        .base=calloc(1, size),
+        .fields=fields_off,
+        .tables=tables_off,
+        .strings=strings_off,
+        .msgs=malloc((msg_count ? msg_count : 1) * sizeof(compiled_msg_t)),
+        .msg_count=msg_count,
+    };
+    compiled_header_init((compiled_header_t *) c.base, size);
+
+    // the messages are placed first, fields refer to them by address.
+    message_t *dst = (message_t *) (c.base + msgs_off);
+    size_t i = 0;
+    for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg), i++) {
+        c.msgs[i].src = msg;
+        c.msgs[i].dst = &dst[i];
+        rel_set(&dst[i].next, i + 1 < msg_count ? &dst[i + 1] : NULL);
+    }
+    qsort(c.msgs, msg_count, sizeof(compiled_msg_t), compiled_msg_compare);
+    i = 0;
+    for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg), i++) {
+        compiler_copy_message(&c, &dst[i], msg);
+    }
+
+    pb_message_list_t *list = (pb_message_list_t *) (c.base + list_off);
+    rel_set(&list->first, msg_count ? &dst[0] : NULL);
+    rel_set(&list->last, msg_count ? &dst[msg_count - 1] : NULL);
+    rel_t *index = compiler_alloc(&c, &c.tables, msgs->index_cap * sizeof(rel_t));
+    for (i = 0; i < msgs->index_cap; i++) {
+        rel_set(&index[i], compiler_find_msg(&c, rel_table_get(&msgs->index, i)));
+    }
+    rel_set(&list->index, index);
+    list->index_cap = msgs->index_cap;
+    list->count = msgs->count;
+    compiler_string(&c, &list->any_type_field, rel_string(&msgs->any_type_field));
+    compiler_string(&c, &list->any_value_field, rel_string(&msgs->any_value_field));
+    list->name_count = msgs->name_count;
+
+    pb_buffer_write(buf, c.base, size);
+    free(c.base);
+    free(c.msgs);
+    return NULL;
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const pb_message_list_t *list;
+    // the messages follow the list as one array.
+    const message_t *msgs;
+    size_t msg_count;
+} compiled_check_t;
+
+// n bytes at p lie inside the image, p aligned to align.
+static bool compiled_check_range(const compiled_check_t *c, const void *p, size_t n, size_t align) {
+    uintptr_t off = (uintptr_t) p - (uintptr_t) c->data;
+    return (uintptr_t) p >= (uintptr_t) c->data && off % align == 0 && off <= c->size && n <= c->size - off;
+}
+
+// a table of n offsets inside the image.
+static bool compiled_check_table(const compiled_check_t *c, const rel_t *table, size_t n) {
+    const void *p = rel_get(table);
+    if (!p) {
+        return n == 0;
+    }
+    return n <= c->size / sizeof(rel_t) && compiled_check_range(c, p, n * sizeof(rel_t), COMPILED_ALIGN);
+}
+
+static bool compiled_check_string(const compiled_check_t *c, const rel_string_t *s) {
+    const char *str = rel_get(&s->str);
+    if (!str) {
+        return s->len == 0;
+    }
+    return s->len < c->size && compiled_check_range(c, str, s->len + 1, 1) && str[s->len] == '\0';
+}
+
+// NULL or one of the messages.
+static bool compiled_check_message_ref(const compiled_check_t *c, const message_t *msg) {
+    uintptr_t off = (uintptr_t) msg - (uintptr_t) c->msgs;
+    return !msg ||
+           ((uintptr_t) msg >= (uintptr_t) c->msgs && off % sizeof(message_t) == 0 &&
+            off / sizeof(message_t) < c->msg_count);
+}
+
+static bool compiled_check_field(const compiled_check_t *c, const field_t *field, int depth) {
+    if (!field) {
+        return true;
+    }
+    return depth < COMPILED_FIELD_DEPTH &&
+           compiled_check_range(c, field, sizeof(field_t), COMPILED_ALIGN) &&
+           field->value_key.len <= FIELD_KEY_MAX_BYTECOUNT &&
+           field->packed_key.len <= FIELD_KEY_MAX_BYTECOUNT &&
+           field->name_index < c->list->name_count &&
+           compiled_check_string(c, &field->name) &&
+           compiled_check_string(c, &field->msg_name) &&
+           compiled_check_message_ref(c, field_msg(field)) &&
+           compiled_check_field(c, field_array_element(field), depth + 1) &&
+           compiled_check_field(c, field_map_key(field), depth + 1) &&
+           compiled_check_field(c, field_map_val(field), depth + 1);
+}
+
+static bool compiled_check_message(const compiled_check_t *c, const message_t *msg) {
+    if (!compiled_check_string(c, &msg->name) || !compiled_check_table(c, &msg->fields, msg->field_count)) {
+        return false;
+    }
+    // the fields are chained in the order of the table.
+    const field_t *prev = NULL;
+    for (size_t i = 0; i < msg->field_count; i++) {
+        const field_t *field = message_field(msg, i);
+        if (!field || !compiled_check_field(c, field, 0) || field->ordinal != i ||
+            (prev ? field_next(prev) : message_first(msg)) != field) {
+            return false;
+        }
+        prev = field;
+    }
+    if ((prev ? field_next(prev) : message_first(msg)) || rel_get(&msg->last) != prev) {
+        return false;
+    }
+    if (!msg->by_tag_len) {
+        return true;
+    }
+    if (!compiled_check_table(c, &msg->by_tag, msg->by_tag_len)) {
+        return false;
+    }
+    for (size_t i = 0; i < msg->by_tag_len; i++) {
+        const field_t *field = rel_table_get(&msg->by_tag, i);
+        // the entries are fields of the message, whose ordinals were checked above.
+        if (field && (!compiled_check_range(c, field, sizeof(field_t), COMPILED_ALIGN) ||
+                      field->ordinal >= msg->field_count || message_field(msg, field->ordinal) != field)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool compiled_check(const compiled_check_t *c) {
+    const pb_message_list_t *list = c->list;
+    // every name but the any keys is the name of a field.
+    if (list->name_count > c->size / sizeof(field_t) + MESSAGES_NAME_ANY_VALUE + 1 ||
+        !compiled_check_string(c, &list->any_type_field) || !compiled_check_string(c, &list->any_value_field)) {
+        return false;
+    }
+    // the index needs a free slot for lookups to end.
+    if (list->index_cap & (list->index_cap - 1) || list->index_cap <= c->msg_count ||
+        !compiled_check_table(c, &list->index, list->index_cap)) {
+        return false;
+    }
+    for (size_t i = 0; i < list->index_cap; i++) {
+        if (!compiled_check_message_ref(c, rel_table_get(&list->index, i))) {
+            return false;
+        }
+    }
+    if (messages_first(list) != (c->msg_count ? &c->msgs[0] : NULL) ||
+        rel_get(&list->last) != (c->msg_count ? &c->msgs[c->msg_count - 1] : NULL)) {
+        return false;
+    }
+    for (size_t i = 0; i < c->msg_count; i++) {
+        const message_t *msg = &c->msgs[i];
+        if (message_next(msg) != (i + 1 < c->msg_count ? &c->msgs[i + 1] : NULL) || !compiled_check_message(c, msg)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+pb_error_t *pb_messages_map(const uint8_t *data, size_t size, pb_message_list_t **msgs) {
+    const compiled_header_t *h = (const compiled_header_t *) data;
+    if (size < sizeof(compiled_header_t) || memcmp(h->magic, COMPILED_MAGIC, sizeof(h->magic)) != 0) {
+        return pb_error_new(PB_ERR_FAIL, "invalid compiled schema");
+    }
+    if (!compiled_header_matches(h)) {
+        return pb_error_new(PB_ERR_FAIL, "compiled schema of another version or layout");
+    }
+    if (h->size != size) {
+        return pb_error_new(PB_ERR_LENGTH, "invalid length of compiled schema: %zu", size);
+    }
+    if ((uintptr_t) data % COMPILED_ALIGN) {
+        return pb_error_new(PB_ERR_FAIL, "misaligned compiled schema");
+    }
+    compiled_check_t c = {.data=data, .size=size};
+    c.list = (const pb_message_list_t *) (data + sizeof(compiled_header_t));
+    c.msgs = (const message_t *) (c.list + 1);
+    if (size < sizeof(compiled_header_t) + sizeof(pb_message_list_t) ||
+        c.list->count > (size - sizeof(compiled_header_t) - sizeof(pb_message_list_t)) / sizeof(message_t)) {
+        return pb_error_new(PB_ERR_FAIL, "corrupted compiled schema");
+    }
+    c.msg_count = c.list->count;
+    if (!compiled_check(&c)) {
+        return pb_error_new(PB_ERR_FAIL, "corrupted compiled schema");
+    }
+    *msgs = (pb_message_list_t *) c.list;
+    return NULL;
+}
@@ -3,7 +3,48 @@
 #include "common.h"
 #include "codec.h"
 
-static void push_default(pb_message_list_t *msgs, pb_state_t *s, field_t *field) {
+typedef struct decoder_t {
+    pb_message_list_t *msgs;
+    uint32_t flags;
+} decoder_t;
+
+static void push_default(decoder_t *d, pb_state_t *s, field_t *field);
+
+// builds the defaults of msg once: a map from field name to default value, message fields map to
+// shared read-only values, repeated fields to new empty maps.
+static void build_defaults(decoder_t *d, pb_state_t *s, message_t *msg) {
+    if (!pb_state_push_new_defaults(s, msg, msg->field_count)) {
+        return;
+    }
+    // the defaults are cached before they are filled, so a message field of the same type finds them.
+    for (size_t i = 0; i < msg->field_count; i++) {
+        field_t *curr = message_field(msg, i);
+        pb_state_push_name(s, curr->name_index, field_name(curr));
+        push_default(d, s, curr);
+        pb_state_add_default(s, i);
+    }
+    pb_state_pop(s);
+}
+
+// sets the defaults of msg on the map at the top, as the decode flags want them. present has a bit
+// set for each field ordinal already in the map, NULL if there are none.
+static void set_defaults(decoder_t *d, pb_state_t *s, message_t *msg, const uint64_t *present) {
+    pb_defaults_mode_t mode = PB_DEFAULTS_COPY;
+    if (d->flags & PB_DECODE_LAZY_DEFAULTS) {
+        mode = PB_DEFAULTS_LAZY;
+    } else if (d->flags & PB_DECODE_SHARED_DEFAULTS) {
+        mode = PB_DEFAULTS_SHARED;
+    }
+    build_defaults(d, s, msg);
+    pb_state_set_defaults(s, msg, mode, present);
+}
+
+// the number of keys a decoded message map gets, lazy defaults only set the present ones.
+static size_t message_map_size(decoder_t *d, message_t *msg) {
+    return d->flags & PB_DECODE_LAZY_DEFAULTS ? 0 : msg->field_count;
+}
+
+static void push_default(decoder_t *d, pb_state_t *s, field_t *field) {
     switch (field->field_wire) {
         case WIRE_LENGTH_DELIMITED:
             switch (field->type) {
@@ -12,35 +53,22 @@ static void push_default(pb_message_list_t *msgs, pb_state_t *s, field_t *field)
                     pb_state_push_string(s, string_new(""));
                     break;
                 case PB_VAL_MESSAGE:
-                    pb_state_push_map(s);
-                    message_t *msg = messages_find(msgs, field->opts.msg.name);
-                    if (!msg) {
-                        break;
-                    }
-                    for (field_t *curr = msg->first; curr; curr = curr->next) {
-                        pb_state_push_string(s, curr->name);
-                        push_default(msgs, s, curr);
-                        pb_state_set_map_element(s);
+                    if (field_msg(field)) {
+                        build_defaults(d, s, field_msg(field));
                     }
+                    pb_state_push_shared_defaults(s, field_msg(field));
                     break;
                 case PB_VAL_ANY:
                     pb_state_push_nil(s);
                     break;
                 default:
                     // packed
-                    pb_state_push_array(s);
+                    pb_state_push_empty_default(s);
                     break;
             }
             break;
         case WIRE_REPEATED:
-            switch (field->type) {
-                case PB_VAL_MAP:
-                    pb_state_push_map(s);
-                    break;
-                default:
-                    pb_state_push_array(s);
-                    break;
-            }
+            pb_state_push_empty_default(s);
             break;
         default:
             switch (field->type) {
@@ -95,6 +123,28 @@ static pb_error_t *read_header(pb_buffer_t *buf, header_t *hdr, size_t *size) {
     return NULL;
 }
 
+// matches the precomputed key bytes of field at the read position, so the key is not decoded.
+static pb_error_t *read_field_header(pb_buffer_t *buf, field_t *field, header_t *h, bool *matched) {
+    size_t size = pb_buffer_size(buf);
+    const uint8_t *p = buf->payload + buf->read;
+    const field_key_t *key = &field->value_key;
+    *matched = false;
+    if (size < key->len || memcmp(p, key->bytes, key->len) != 0) {
+        key = &field->packed_key;
+        if (key->wire == field->value_wire || size < key->len || memcmp(p, key->bytes, key->len) != 0) {
+            return NULL;
+        }
+    }
+    *matched = true;
+    buf->read += key->len;
+    h->tag = field->tag;
+    h->wire = key->wire;
+    if (h->wire == WIRE_LENGTH_DELIMITED) {
+        return varint_decode(buf, &h->len, NULL);
+    }
+    return NULL;
+}
+
 static pb_error_t *read_string_ignore_wire(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h, size_t *size) {
     uint8_t *payload = pb_buffer_step_read(buf, h->len);
     if (!payload) {
@@ -116,7 +166,7 @@ static pb_error_t *read_string(pb_buffer_t *buf, pb_state_t *s, field_t *field,
         return pb_error_new(
             PB_ERR_WIRE,
             "invalid wire for field %s, expect %s, got %s",
-            field->name.str,
+            field_name(field).str,
             wire_name(field->field_wire),
             wire_name((wire_t) h->wire)
         );
@@ -200,71 +250,193 @@ static pb_error_t *read_number_ignore_wire(pb_buffer_t *buf, pb_state_t *s, fiel
             return pb_error_new(
                 PB_ERR_FAIL,
                 "internal error: invalid field type: %s, %d",
-                field->name.str,
+                field_name(field).str,
                 field->type
             );
     }
     return NULL;
 }
 
-static pb_error_t *read_packed_number(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h, size_t *size) {
-    if (field->field_wire != h->wire) {
+static pb_error_t *read_number(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h, size_t *size) {
+    if (field->value_wire != h->wire) {
         return pb_error_new(
             PB_ERR_WIRE,
             "invalid wire for field: %s, expect %s, got %s",
-            field->name,
-            wire_name(field->field_wire),
+            field_name(field).str,
+            wire_name(field->value_wire),
             wire_name((wire_t) h->wire)
         );
     }
     return read_number_ignore_wire(buf, s, field, h, size);
 }
 
-static pb_error_t *read_number(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h, size_t *size) {
-    if (field->value_wire != h->wire) {
+static pb_error_t *decode_packed_fixed(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h, size_t width) {
+    if (field->field_wire != h->wire) {
         return pb_error_new(
             PB_ERR_WIRE,
             "invalid wire for field: %s, expect %s, got %s",
-            field->name,
-            wire_name(field->value_wire),
+            field_name(field).str,
+            wire_name(field->field_wire),
             wire_name((wire_t) h->wire)
         );
     }
-    return read_number_ignore_wire(buf, s, field, h, size);
+    if (h->len % width != 0) {
+        return pb_error_new(PB_ERR_LENGTH, "invalid length for field %s", field_name(field).str);
+    }
+    const uint8_t *p = pb_buffer_step_read(buf, h->len);
+    if (!p) {
+        return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+    }
+    size_t count = h->len / width,
+        base = pb_state_get_objlen(s, pb_state_stack_top(0));
+    switch (field->type) {
+        case PB_VAL_FLOAT:
+            for (size_t i = 0; i < count; i++, p += BIT32_BYTECOUNT) {
+                pb_state_push_float(s, uint32_to_float(bits_load_le32(p)));
+                pb_state_set_array_element(s, base + i);
+            }
+            break;
+        case PB_VAL_FIXED32:
+            for (size_t i = 0; i < count; i++, p += BIT32_BYTECOUNT) {
+                pb_state_push_uint32(s, bits_load_le32(p));
+                pb_state_set_array_element(s, base + i);
+            }
+            break;
+        case PB_VAL_SFIXED32:
+            for (size_t i = 0; i < count; i++, p += BIT32_BYTECOUNT) {
+                pb_state_push_int32(s, (int32_t) bits_load_le32(p));
+                pb_state_set_array_element(s, base + i);
+            }
+            break;
+        case PB_VAL_DOUBLE:
+            for (size_t i = 0; i < count; i++, p += BIT64_BYTECOUNT) {
+                pb_state_push_double(s, uint64_to_double(bits_load_le64(p)));
+                pb_state_set_array_element(s, base + i);
+            }
+            break;
+        case PB_VAL_FIXED64:
+            for (size_t i = 0; i < count; i++, p += BIT64_BYTECOUNT) {
+                pb_state_push_uint64(s, bits_load_le64(p));
+                pb_state_set_array_element(s, base + i);
+            }
+            break;
+        case PB_VAL_SFIXED64:
+            for (size_t i = 0; i < count; i++, p += BIT64_BYTECOUNT) {
+                pb_state_push_int64(s, (int64_t) bits_load_le64(p));
+                pb_state_set_array_element(s, base + i);
+            }
+            break;
+        default:
+            return pb_error_new(
+                PB_ERR_FAIL,
+                "internal error: invalid field type: %s, %d",
+                field_name(field).str,
+                field->type
+            );
+    }
+    return NULL;
 }
 
-static pb_error_t *decode_packed(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
-    pb_error_t *err = NULL;
-    size_t n = 0;
-    while (1) {
-        if (n == h->len) {
-            break;
-        }
-        if (n > h->len) {
-            return pb_error_new(PB_ERR_LENGTH, "invalid length for field %s", field->name.str);
+#define PACKED_VARINT_CHUNK 64
+
+static pb_error_t *decode_packed_varint(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+    if (field->field_wire != h->wire) {
+        return pb_error_new(
+            PB_ERR_WIRE,
+            "invalid wire for field: %s, expect %s, got %s",
+            field_name(field).str,
+            wire_name(field->field_wire),
+            wire_name((wire_t) h->wire)
+        );
+    }
+    const uint8_t *p = pb_buffer_step_read(buf, h->len);
+    if (!p) {
+        return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+    }
+    uint64_t vals[PACKED_VARINT_CHUNK];
+    size_t off = 0,
+        index = pb_state_get_objlen(s, pb_state_stack_top(0));
+    while (off < h->len) {
+        size_t used = 0;
+        size_t n = varint_decode_run(p + off, h->len - off, vals, PACKED_VARINT_CHUNK, &used);
+        if (n < PACKED_VARINT_CHUNK && off + used < h->len) {
+            return pb_error_new(PB_ERR_VARINT, "invalid varint for field %s", field_name(field).str);
         }
-        pb_state_push_array_index(s, (int) pb_state_get_objlen(s, pb_state_stack_top(0)));
-        err = read_packed_number(buf, s, field, h, &n);
-        if (err) {
-            pb_state_pop(s);
-            break;
+        off += used;
+        switch (field->type) {
+            case PB_VAL_BOOL:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_bool(s, vals[i] > 0);
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            case PB_VAL_SINT32:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_int32(s, bit32_dezigzag((int32_t) vals[i]));
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            case PB_VAL_INT32:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_int32(s, (int32_t) vals[i]);
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            case PB_VAL_ENUM:
+            case PB_VAL_UINT32:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_uint32(s, (uint32_t) vals[i]);
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            case PB_VAL_SINT64:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_int64(s, bit64_dezigzag((int64_t) vals[i]));
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            case PB_VAL_INT64:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_int64(s, (int64_t) vals[i]);
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            case PB_VAL_UINT64:
+                for (size_t i = 0; i < n; i++) {
+                    pb_state_push_uint64(s, vals[i]);
+                    pb_state_set_array_element(s, index++);
+                }
+                break;
+            default:
+                return pb_error_new(
+                    PB_ERR_FAIL,
+                    "internal error: invalid field type: %s, %d",
+                    field_name(field).str,
+                    field->type
+                );
         }
-        pb_state_append_array_element(s);
     }
-    return err;
+    return NULL;
 }
 
-static pb_error_t *decode_all(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h);
+static pb_error_t *decode_packed(pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+    size_t width = wire_fixed_bytecount(field->value_wire);
+    if (width) {
+        return decode_packed_fixed(buf, s, field, h, width);
+    }
+    return decode_packed_varint(buf, s, field, h);
+}
 
-static pb_error_t *
-decode_custom_message_no_header(pb_message_list_t *msgs, message_t *msg, pb_buffer_t *buf, pb_state_t *s, size_t len);
+static pb_error_t *decode_all(decoder_t *d, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h);
 
 static pb_error_t *
-decode_custom_message_no_header_by_name(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name,
-                                        size_t len);
+decode_custom_message_no_header(decoder_t *d, message_t *msg, pb_buffer_t *buf, pb_state_t *s, size_t len);
 
-static pb_error_t *decode_any(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+static pb_error_t *decode_any(decoder_t *d, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
     size_t size = pb_buffer_size(buf);
+    if (h->len > size) {
+        return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+    }
     header_t h_typ = {};
     pb_error_t *err = read_header(buf, &h_typ, NULL);
     if (err) {
@@ -277,14 +449,14 @@ static pb_error_t *decode_any(pb_message_list_t *msgs, pb_buffer_t *buf, pb_stat
     pb_string_t msg_name = pb_state_get_string(s, pb_state_stack_top(0));
     pb_state_pop(s);
 
-    message_t *msg = messages_find(msgs, msg_name);
+    message_t *msg = messages_find(d->msgs, msg_name);
     if (!msg) {
         // ignore
-        push_default(msgs, s, field);
+        push_default(d, s, field);
 
         size_t read = size - pb_buffer_size(buf);
         if (read > h->len) {
-            return pb_error_new(PB_ERR_LENGTH, "invalid length for field: %s", field->name.str);
+            return pb_error_new(PB_ERR_LENGTH, "invalid length for field: %s", field_name(field).str);
         }
         pb_buffer_discard(buf, h->len - read);
         return NULL;
@@ -295,46 +467,57 @@ static pb_error_t *decode_any(pb_message_list_t *msgs, pb_buffer_t *buf, pb_stat
     if (err) {
         return err;
     }
-    return decode_custom_message_no_header(msgs, msg, buf, s, h_val.len);
+    return decode_custom_message_no_header(d, msg, buf, s, h_val.len);
 }
 
 static pb_error_t *
-decode_length_delimited(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+decode_length_delimited(decoder_t *d, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
     switch (field->type) {
         case PB_VAL_STRING:
         case PB_VAL_BYTES:
             return read_string(buf, s, field, h, NULL);
         case PB_VAL_MESSAGE:
-            return decode_custom_message_no_header_by_name(msgs, buf, s, field->opts.msg.name, h->len);
+            if (!field_msg(field)) {
+                return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", field_msg_name(field).str);
+            }
+            return decode_custom_message_no_header(d, field_msg(field), buf, s, h->len);
         case PB_VAL_ANY:
-            return decode_any(msgs, buf, s, field, h);
+            return decode_any(d, buf, s, field, h);
         default:
             return decode_packed(buf, s, field, h);
     }
 }
 
 static pb_error_t *
-decode_repeated(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+decode_repeated(decoder_t *d, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
     pb_error_t *err = NULL;
     if (field->type == PB_VAL_MAP) {
-        if (!field->map_key || !field->map_val) {
+        if (!field_map_key(field) || !field_map_val(field)) {
             goto MAP_END;
         }
 
+        if (h->len > pb_buffer_size(buf)) {
+            err = pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+            goto MAP_END;
+        }
         header_t h_key = {};
         pb_buffer_t nbuf;
         pb_buffer_readonly(&nbuf, buf, h->len);
 
-        err = read_header(&nbuf, &h_key, NULL);
+        bool matched;
+        err = read_field_header(&nbuf, field_map_key(field), &h_key, &matched);
+        if (!err && !matched) {
+            err = read_header(&nbuf, &h_key, NULL);
+        }
         if (err) {
             goto MAP_END;
         }
-        switch (field->map_key->field_wire) {
+        switch (field_map_key(field)->field_wire) {
             case WIRE_LENGTH_DELIMITED:
-                err = read_string(&nbuf, s, field->map_key, &h_key, NULL);
+                err = read_string(&nbuf, s, field_map_key(field), &h_key, NULL);
                 break;
             default:
-                err = read_number(&nbuf, s, field->map_key, &h_key, NULL);
+                err = read_number(&nbuf, s, field_map_key(field), &h_key, NULL);
                 break;
         }
         if (err) {
@@ -342,12 +525,22 @@ decode_repeated(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_
         }
 
         if (pb_buffer_size(&nbuf) == 0) {
-            push_default(msgs, s, field->map_val);
+            if (field_map_val(field)->type == PB_VAL_MESSAGE) {
+                pb_state_push_sized_map(s, field_msg(field_map_val(field)) ? message_map_size(d, field_msg(field_map_val(field))) : 0);
+                if (field_msg(field_map_val(field))) {
+                    set_defaults(d, s, field_msg(field_map_val(field)), NULL);
+                }
+            } else {
+                push_default(d, s, field_map_val(field));
+            }
         } else {
             header_t h_val = {};
-            err = read_header(&nbuf, &h_val, NULL);
+            err = read_field_header(&nbuf, field_map_val(field), &h_val, &matched);
+            if (!err && !matched) {
+                err = read_header(&nbuf, &h_val, NULL);
+            }
             if (!err) {
-                err = decode_all(msgs, &nbuf, s, field->map_val, &h_val);
+                err = decode_all(d, &nbuf, s, field_map_val(field), &h_val);
             }
             if (err) {
                 pb_state_pop(s);
@@ -360,33 +553,68 @@ decode_repeated(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_
             pb_buffer_discard(buf, h->len);
             pb_state_set_map_element(s);
         }
-    } else if (field->array_element) {
-        pb_state_push_array_index(s, (int) pb_state_get_objlen(s, pb_state_stack_top(0)));
-        err = decode_all(msgs, buf, s, field->array_element, h);
-        if (err) {
-            pb_state_pop(s);
-        } else {
-            pb_state_append_array_element(s);
+    } else if (field_array_element(field)) {
+        // the elements in a row are appended together, the length of the array is taken once.
+        size_t index = pb_state_get_objlen(s, pb_state_stack_top(0));
+        bool matched = true;
+        while (matched && !err) {
+            err = decode_all(d, buf, s, field_array_element(field), h);
+            if (!err) {
+                pb_state_set_array_element(s, index++);
+                err = read_field_header(buf, field, h, &matched);
+            }
         }
     }
     return err;
 }
 
-static pb_error_t *decode_all(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+static pb_error_t *decode_all(decoder_t *d, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
     switch (field->field_wire) {
         case WIRE_LENGTH_DELIMITED:
-            return decode_length_delimited(msgs, buf, s, field, h);
+            return decode_length_delimited(d, buf, s, field, h);
         case WIRE_REPEATED:
-            return decode_repeated(msgs, buf, s, field, h);
+            return decode_repeated(d, buf, s, field, h);
         case WIRE_VARINT:
         case WIRE_BIT32:
         case WIRE_BIT64:
             return read_number(buf, s, field, h, NULL);
         default:
-            return pb_error_new(PB_ERR_FAIL, "internal error, invalid wire for field %s", field->name.str);
+            return pb_error_new(PB_ERR_FAIL, "internal error, invalid wire for field %s", field_name(field).str);
     }
 }
 
+static pb_error_t *decode_skip_field(pb_buffer_t *buf, header_t *h) {
+    switch (h->wire) {
+        case WIRE_LENGTH_DELIMITED:
+            if (pb_buffer_discard(buf, h->len) != h->len) {
+                return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+            }
+            return NULL;
+        default:
+            return read_number_ignore_wire(buf, NULL, NULL, h, NULL);
+    }
+}
+
+// counts the elements of field in the run starting with the one whose header h was just read. the
+// count only sizes the container, an error ends the run and is met again when the elements are
+// decoded.
+static size_t repeated_run_count(pb_buffer_t *buf, field_t *field, header_t *h) {
+    pb_buffer_t run;
+    pb_buffer_readonly(&run, buf, pb_buffer_size(buf));
+    header_t curr = *h;
+    size_t count = 0;
+    bool matched = true;
+    pb_error_t *err = NULL;
+    while (matched && !(err = decode_skip_field(&run, &curr))) {
+        count++;
+        if ((err = read_field_header(&run, field, &curr, &matched))) {
+            break;
+        }
+    }
+    pb_error_free(err);
+    return count;
+}
+
 static bool field_is_packed(field_t *field) {
     if (field->field_wire != WIRE_LENGTH_DELIMITED) {
         return false;
@@ -398,24 +626,34 @@ static bool field_is_packed(field_t *field) {
         case PB_VAL_BYTES:
             return false;
         default:
-            return field->opts.primitive.packed;
+            return field->packed;
     }
 }
 
 static pb_error_t *
-decode_message_field(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
-    pb_state_push_string(s, field->name);
+decode_message_field(decoder_t *d, pb_buffer_t *buf, pb_state_t *s, field_t *field, header_t *h) {
+    pb_state_push_name(s, field->name_index, field_name(field));
     bool is_repeated = field->field_wire == WIRE_REPEATED || field_is_packed(field);
     if (is_repeated) {
-        if (!pb_state_get_map_element(s, pb_state_stack_top(-1), field->name)) {
+        if (!pb_state_get_map_element_by_name(s, pb_state_stack_top(-1), field->name_index, field_name(field))) {
+            size_t width;
             if (field->type == PB_VAL_MAP) {
-                pb_state_push_map(s);
+                pb_state_push_sized_map(s, repeated_run_count(buf, field, h));
+            } else if (h->wire == WIRE_LENGTH_DELIMITED && pb_buffer_size(buf) >= h->len &&
+                       (width = wire_fixed_bytecount(field->value_wire))) {
+                // packed fixed width elements, the count is known from the length.
+                pb_state_push_sized_array(s, h->len / width);
+            } else if (h->wire == WIRE_LENGTH_DELIMITED && pb_buffer_size(buf) >= h->len &&
+                       field->value_wire == WIRE_VARINT) {
+                // packed varints, one per terminating byte.
+                pb_state_push_sized_array(s, varint_count(buf->payload + buf->read, h->len));
             } else {
-                pb_state_push_array(s);
+                // elements with a key each, the ones in a row are counted.
+                pb_state_push_sized_array(s, repeated_run_count(buf, field, h));
             }
         }
     }
-    pb_error_t *err = decode_all(msgs, buf, s, field, h);
+    pb_error_t *err = decode_all(d, buf, s, field, h);
     if (err) {
         if (is_repeated) {
             pb_state_pop(s);
@@ -428,94 +666,53 @@ decode_message_field(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, f
     return NULL;
 }
 
-typedef struct tag_node_t tag_node_t;
-
-struct tag_node_t {
-    uint64_t tag;
-    tag_node_t *next;
-};
+// fields seen while decoding a message, one bit per field ordinal. messages with more fields
+// than fit the stack words use the heap.
+#define PRESENCE_STACK_WORDS 4
 
-typedef struct tag_list_t {
-    tag_node_t *head;
-    tag_node_t *tail;
-} tag_list_t;
+typedef struct presence_t {
+    uint64_t *words;
+    uint64_t stack[PRESENCE_STACK_WORDS];
+} presence_t;
 
-static tag_list_t *tags_new() {
-    return calloc(1, sizeof(tag_list_t));
-}
-
-static tag_node_t *tags_node_new(tag_node_t *next, uint64_t tag) {
-    tag_node_t *n = malloc(sizeof(tag_node_t));
-    n->next = next;
-    n->tag = tag;
-    return n;
-}
-
-static void tags_free(tag_list_t *tags) {
-    tag_node_t *curr = tags->head, *tmp;
-    while (curr) {
-        tmp = curr->next;
-        free(curr);
-        curr = tmp;
-    }
-    free(tags);
-}
-
-static bool tags_append(tag_list_t *tags, uint64_t tag) {
-    tag_node_t *tail = tags->tail;
-    if (!tail) {
-        tags->head = tags->tail = tags_node_new(NULL, tag);
-        return true;
-    }
-    if (tail->tag == tag) {
-        return false;
+static void presence_init(presence_t *p, size_t count) {
+    size_t n = (count + 63) / 64;
+    if (n <= PRESENCE_STACK_WORDS) {
+        p->words = p->stack;
+        memset(p->stack, 0, sizeof(p->stack));
+    } else {
+        p->words = calloc(n, sizeof(uint64_t));
     }
-    tags->tail = tail->next = tags_node_new(tail->next, tag);
-    return true;
 }
 
-static bool tags_remove(tag_list_t *tags, uint64_t tag) {
-    tag_node_t *prev = NULL, *curr = tags->head;
-    while (curr) {
-        if (curr->tag == tag) {
-            tag_node_t *tmp = curr->next;
-            free(curr);
-            if (!prev) {
-                tags->head = tmp;
-            } else {
-                prev->next = tmp;
-            }
-            if (!tmp) {
-                tags->tail = prev;
-            }
-            return true;
-        }
-
-        prev = curr;
-        curr = curr->next;
+static void presence_free(presence_t *p) {
+    if (p->words != p->stack) {
+        free(p->words);
     }
-    return false;
 }
 
-
-static pb_error_t *decode_skip_field(pb_buffer_t *buf, header_t *h) {
-    switch (h->wire) {
-        case WIRE_LENGTH_DELIMITED:
-            if (pb_buffer_discard(buf, h->len) != h->len) {
-                return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
-            }
-            return NULL;
-        default:
-            return read_number_ignore_wire(buf, NULL, NULL, h, NULL);
-    }
+// returns true if the bit was not set yet.
+static inline bool presence_set(presence_t *p, size_t ordinal) {
+    uint64_t bit = 1ULL << (ordinal & 63),
+        word = p->words[ordinal >> 6];
+    p->words[ordinal >> 6] = word | bit;
+    return !(word & bit);
 }
 
 static pb_error_t *
-decode_custom_message_no_header(pb_message_list_t *msgs, message_t *msg, pb_buffer_t *buf, pb_state_t *s, size_t len) {
-    pb_state_push_map(s);
+decode_custom_message_no_header(decoder_t *d, message_t *msg, pb_buffer_t *buf, pb_state_t *s, size_t len) {
+    // the input is read in place, a body must not reach past it.
+    if (len > pb_buffer_size(buf)) {
+        return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+    }
+    if (!pb_state_check_stack(s, MESSAGE_STACK_SLOTS)) {
+        return pb_error_new(PB_ERR_FAIL, "message nested too deep");
+    }
+    pb_state_push_sized_map(s, message_map_size(d, msg));
     pb_error_t *err = NULL;
-    tag_list_t *tags = tags_new();
-    size_t appeared = 0;
+    presence_t presence;
+    presence_init(&presence, msg->field_count);
+    size_t seen = 0;
 
     pb_buffer_t nbuf;
     pb_buffer_readonly(&nbuf, buf, len);
@@ -523,11 +720,29 @@ decode_custom_message_no_header(pb_message_list_t *msgs, message_t *msg, pb_buff
     field_t *currField = NULL;
     while (pb_buffer_size(&nbuf) > 0) {
         header_t h = {};
-        err = read_header(&nbuf, &h, NULL);
+        // fields usually come in schema order, repeated ones in runs: try the raw keys of the
+        // current and the next field before decoding the key.
+        bool matched = false;
+        size_t next_ordinal = currField ? currField->ordinal + 1 : 0;
+        field_t *next = next_ordinal < msg->field_count ? message_field(msg, next_ordinal) : NULL;
+        if (currField && currField->field_wire == WIRE_REPEATED) {
+            err = read_field_header(&nbuf, currField, &h, &matched);
+        }
+        if (!err && !matched && next) {
+            err = read_field_header(&nbuf, next, &h, &matched);
+            if (matched) {
+                currField = next;
+            }
+        }
+        if (!err && !matched) {
+            err = read_header(&nbuf, &h, NULL);
+            if (!err) {
+                currField = message_find_field_by_tag(msg, h.tag);
+            }
+        }
         if (err) {
             break;
         }
-        currField = message_find_field_by_tag(msg, currField, h.tag);
         if (!currField) {
             err = decode_skip_field(&nbuf, &h);
             if (err) {
@@ -535,45 +750,49 @@ decode_custom_message_no_header(pb_message_list_t *msgs, message_t *msg, pb_buff
             }
             continue;
         }
-        err = decode_message_field(msgs, &nbuf, s, currField, &h);
+        err = decode_message_field(d, &nbuf, s, currField, &h);
         if (err) {
             break;
         }
-        if (tags_append(tags, h.tag)) {
-            appeared++;
+        if (presence_set(&presence, currField->ordinal)) {
+            seen++;
         }
     }
-    if (err) {
-        pb_state_pop(s);
-        tags_free(tags);
-        return err;
-    }
-    pb_buffer_discard(buf, len);
-    if (1) {
-        field_t *curr = msg->first;
-        while (curr) {
-            if (!tags_remove(tags, curr->tag)) {
-                pb_state_push_string(s, curr->name);
-                push_default(msgs, s, curr);
-                pb_state_set_map_element(s);
-            }
-            curr = curr->next;
+    if (!err) {
+        pb_buffer_discard(buf, len);
+        if (seen < msg->field_count || d->flags & PB_DECODE_LAZY_DEFAULTS) {
+            set_defaults(d, s, msg, presence.words);
         }
+    } else {
+        pb_state_pop(s);
     }
-    tags_free(tags);
-    return NULL;
+    presence_free(&presence);
+    return err;
 }
 
 static pb_error_t *
 decode_custom_message_no_header_by_name(
-    pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name, size_t len) {
-    message_t *msg = messages_find(msgs, msg_name);
+    decoder_t *d, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name, size_t len) {
+    message_t *msg = messages_find(d->msgs, msg_name);
     if (!msg) {
         return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", msg_name.str);
     }
-    return decode_custom_message_no_header(msgs, msg, buf, s, len);
+    return decode_custom_message_no_header(d, msg, buf, s, len);
+}
+
+pb_error_t *pb_decode_message_flags(
+    pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name, uint32_t flags) {
+    decoder_t d = {.msgs=msgs, .flags=flags};
+    // the decoded maps have no metamethods until they are done.
+    bool raw = pb_state_raw_access(s);
+    pb_state_set_raw_access(s, true);
+    messages_use_names(msgs, s);
+    pb_error_t *err = decode_custom_message_no_header_by_name(&d, buf, s, msg_name, pb_buffer_size(buf));
+    pb_state_release_names(s);
+    pb_state_set_raw_access(s, raw);
+    return err;
 }
 
 pb_error_t *pb_decode_message(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name) {
-    return decode_custom_message_no_header_by_name(msgs, buf, s, msg_name, pb_buffer_size(buf));
+    return pb_decode_message_flags(msgs, buf, s, msg_name, 0);
 }
\ No newline at end of file
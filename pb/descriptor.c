@@ -1,157 +1,434 @@
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "pb.h"
 #include "common.h"
+#include "codec.h"
 
-static pb_error_t *messages_new_from_state(pb_state_t *state, pb_message_list_t *msgs) {
-    pb_error_t *err = NULL;
-    while (!err && pb_state_iter_map_element_pair(state)) {
-        int key_index = pb_state_stack_top(-1),
-            stack_top = pb_state_stack_top(0);
-
-        pb_string_t key = pb_state_get_string(state, key_index);
-        message_t *msg = message_new(key);
-        messages_append_msg(msgs, msg);
-
-        pb_state_get_map_element(state, stack_top, string_new("fields"));
-        size_t len = pb_state_get_objlen(state, stack_top);
-        for (int i = 0; i < len && !err; i++) {
-            pb_state_get_array_element(state, stack_top, i);
-
-            uint32_t type = 0;
-            uint32_t tag = 0;
-            pb_string_t name = {};
-            bool repeated = false;
-            bool packed = false;
-            pb_string_t msg_name = {};
-            pb_string_t val_msg_name = {};
-            uint32_t key_type = 0;
-            uint32_t val_type = 0;
-            int count = 0;
-            if (pb_state_get_map_element(state, stack_top - count, string_new("type"))) {
-                count++;
-                type = pb_state_get_uint32(state, stack_top);
-            }
-            if (pb_state_get_map_element(state, stack_top - count, string_new("tag"))) {
-                count++;
-                tag = pb_state_get_uint32(state, stack_top);
-            }
-            if (pb_state_get_map_element(state, stack_top - count, string_new("name"))) {
-                count++;
-                name = pb_state_get_string(state, stack_top);
+/**
+ * the descriptor parser reads a FileDescriptorSet straight into messages. only the parts of
+ * descriptor.proto the codecs use are read, everything else is skipped.
+ *
+ * map fields refer to a nested map entry type, which may be declared after the field, so the
+ * set is read twice: the first pass collects the map entries, the second builds the messages.
+ */
+#define DESC_ANY_TYPE_NAME "google.protobuf.Any"
+#define DESC_LABEL_REPEATED 3
+
+// the tags of the descriptor.proto fields that are read.
+enum {
+    DESC_SET_FILE = 1,
+
+    DESC_FILE_PACKAGE = 2,
+    DESC_FILE_MESSAGE_TYPE = 4,
+
+    DESC_TYPE_NAME = 1,
+    DESC_TYPE_FIELD = 2,
+    DESC_TYPE_NESTED_TYPE = 3,
+    DESC_TYPE_OPTIONS = 7,
+    DESC_TYPE_OPTIONS_MAP_ENTRY = 7,
+
+    DESC_FIELD_NAME = 1,
+    DESC_FIELD_NUMBER = 3,
+    DESC_FIELD_LABEL = 4,
+    DESC_FIELD_TYPE = 5,
+    DESC_FIELD_TYPE_NAME = 6,
+    DESC_FIELD_OPTIONS = 8,
+    DESC_FIELD_OPTIONS_PACKED = 2,
+};
+
+typedef struct {
+    pb_message_list_t *msgs;
+    // the map entry types, read by the first pass.
+    pb_message_list_t *maps;
+    bool collect_maps;
+
+    // the full name of the type being read, as "package.Outer.Inner".
+    char *name;
+    size_t name_len;
+    size_t name_cap;
+} desc_parser_t;
+
+typedef struct {
+    pb_string_t name;
+    uint64_t number;
+    uint64_t label;
+    uint64_t type;
+    // the full name of a message or enum type, without the leading '.'.
+    pb_string_t type_name;
+    bool packed;
+} desc_field_t;
+
+static pb_error_t *desc_wire_error(header_t *h) {
+    return pb_error_new(PB_ERR_WIRE, "invalid descriptor wire %s for field %d", wire_name(h->wire), (int) h->tag);
+}
+
+// reads the header of the next field of buf, false at the end of buf or once err is set.
+static bool desc_next(pb_buffer_t *buf, header_t *h, pb_error_t **err) {
+    if (*err || !pb_buffer_size(buf)) {
+        return false;
+    }
+    *err = varint_decode(buf, &h->tag, NULL);
+    if (*err) {
+        return false;
+    }
+    h->wire = (uint8_t) (h->tag & HEADER_WIRE_MASK);
+    h->tag >>= HEADER_WIRE_BITCOUNT;
+    h->len = 0;
+    if (h->wire == WIRE_LENGTH_DELIMITED) {
+        *err = varint_decode(buf, &h->len, NULL);
+    }
+    return !*err;
+}
+
+// makes payload read the length delimited field h in place.
+static pb_error_t *desc_read_bytes(pb_buffer_t *buf, header_t *h, pb_buffer_t *payload) {
+    if (h->wire != WIRE_LENGTH_DELIMITED) {
+        return desc_wire_error(h);
+    }
+    uint8_t *p = pb_buffer_step_read(buf, h->len);
+    if (!p) {
+        return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
+    }
+    pb_buffer_wrap(payload, p, h->len);
+    return NULL;
+}
+
+static pb_error_t *desc_read_string(pb_buffer_t *buf, header_t *h, pb_string_t *str) {
+    pb_buffer_t payload;
+    pb_error_t *err = desc_read_bytes(buf, h, &payload);
+    if (!err) {
+        str->str = (const char *) payload.payload;
+        str->len = h->len;
+    }
+    return err;
+}
+
+static pb_error_t *desc_read_varint(pb_buffer_t *buf, header_t *h, uint64_t *v) {
+    if (h->wire != WIRE_VARINT) {
+        return desc_wire_error(h);
+    }
+    return varint_decode(buf, v, NULL);
+}
+
+static pb_error_t *desc_read_bool(pb_buffer_t *buf, header_t *h, bool *v) {
+    uint64_t n = 0;
+    pb_error_t *err = desc_read_varint(buf, h, &n);
+    *v = n != 0;
+    return err;
+}
+
+static pb_error_t *desc_skip(pb_buffer_t *buf, header_t *h) {
+    uint64_t n;
+    pb_buffer_t payload;
+    switch (h->wire) {
+        case WIRE_VARINT:
+            return varint_decode(buf, &n, NULL);
+        case WIRE_BIT32:
+        case WIRE_BIT64:
+            n = wire_fixed_bytecount(h->wire);
+            if (pb_buffer_discard(buf, n) != n) {
+                return pb_error_new(PB_ERR_UNEXPECTED_EOF, "unexpected EOF");
             }
-            if (pb_state_get_map_element(state, stack_top - count, string_new("repeated"))) {
-                count++;
-                repeated = pb_state_get_bool(state, stack_top);
+            return NULL;
+        case WIRE_LENGTH_DELIMITED:
+            return desc_read_bytes(buf, h, &payload);
+        default:
+            return desc_wire_error(h);
+    }
+}
+
+// reads the bool option with tag of the options message h.
+static pb_error_t *desc_read_bool_option(pb_buffer_t *buf, header_t *h, uint64_t tag, bool *v) {
+    pb_buffer_t opts;
+    pb_error_t *err = desc_read_bytes(buf, h, &opts);
+    header_t oh;
+    while (desc_next(&opts, &oh, &err)) {
+        if (oh.tag == tag) {
+            err = desc_read_bool(&opts, &oh, v);
+        } else {
+            err = desc_skip(&opts, &oh);
+        }
+    }
+    return err;
+}
+
+// appends name to the full name, returns the length to restore once the type is read.
+static size_t desc_push_name(desc_parser_t *p, pb_string_t name) {
+    size_t mark = p->name_len;
+    if (!name.len) {
+        return mark;
+    }
+    if (p->name_len + name.len + 1 > p->name_cap) {
+        p->name_cap = (p->name_len + name.len + 1) * 2;
+        p->name = realloc(p->name, p->name_cap);
+    }
+    if (p->name_len) {
+        p->name[p->name_len++] = '.';
+    }
+    memcpy(p->name + p->name_len, name.str, name.len);
+    p->name_len += name.len;
+    return mark;
+}
+
+static pb_string_t desc_name(desc_parser_t *p) {
+    pb_string_t name = {.str=p->name, .len=p->name_len};
+    return name;
+}
+
+// the list the types of the current pass go to, map entries are collected on their own.
+static pb_message_list_t *desc_list(desc_parser_t *p) {
+    return p->collect_maps ? p->maps : p->msgs;
+}
+
+static bool desc_string_is(pb_string_t s, const char *str) {
+    size_t len = strlen(str);
+    return s.len == len && memcmp(s.str, str, len) == 0;
+}
+
+static pb_error_t *desc_read_field(pb_buffer_t *buf, header_t *h, desc_field_t *f) {
+    pb_buffer_t field;
+    pb_error_t *err = desc_read_bytes(buf, h, &field);
+    header_t fh;
+    while (desc_next(&field, &fh, &err)) {
+        switch (fh.tag) {
+            case DESC_FIELD_NAME:
+                err = desc_read_string(&field, &fh, &f->name);
+                break;
+            case DESC_FIELD_NUMBER:
+                err = desc_read_varint(&field, &fh, &f->number);
+                break;
+            case DESC_FIELD_LABEL:
+                err = desc_read_varint(&field, &fh, &f->label);
+                break;
+            case DESC_FIELD_TYPE:
+                err = desc_read_varint(&field, &fh, &f->type);
+                break;
+            case DESC_FIELD_TYPE_NAME:
+                err = desc_read_string(&field, &fh, &f->type_name);
+                if (!err && f->type_name.len && f->type_name.str[0] == '.') {
+                    f->type_name.str++;
+                    f->type_name.len--;
+                }
+                break;
+            case DESC_FIELD_OPTIONS:
+                err = desc_read_bool_option(&field, &fh, DESC_FIELD_OPTIONS_PACKED, &f->packed);
+                break;
+            default:
+                err = desc_skip(&field, &fh);
+                break;
+        }
+    }
+    return err;
+}
+
+static field_t *desc_find_field(message_t *msg, uint64_t tag) {
+    for (field_t *field = message_first(msg); field; field = field_next(field)) {
+        if (field->tag == tag) {
+            return field;
+        }
+    }
+    return NULL;
+}
+
+static pb_error_t *
+desc_map_field_new(pb_message_list_t *msgs, pb_string_t name, uint64_t tag, message_t *entry, field_t **out) {
+    field_t *key = desc_find_field(entry, PB_MAP_KEY_TAG),
+        *val = desc_find_field(entry, PB_MAP_VAL_TAG);
+    if (!key || !val) {
+        pb_string_t entry_name = message_name(entry);
+        return pb_error_new(PB_ERR_FAIL, "invalid map entry type: %.*s", (int) entry_name.len, entry_name.str);
+    }
+    pb_string_t val_msg_name = {};
+    if (val->type == PB_VAL_MESSAGE) {
+        val_msg_name = field_msg_name(val);
+    }
+    *out = field_new(msgs, name, tag, PB_VAL_MAP, field_opts_map(key->type, val->type, val_msg_name));
+    return NULL;
+}
+
+// the field described by f, with map and any values resolved.
+static pb_error_t *desc_field_new(desc_parser_t *p, desc_field_t *f, field_t **out) {
+    pb_message_list_t *msgs = desc_list(p);
+    bool repeated = f->label == DESC_LABEL_REPEATED;
+    message_t *entry;
+    switch (f->type) {
+        case PB_VAL_DOUBLE:
+        case PB_VAL_FLOAT:
+        case PB_VAL_INT64:
+        case PB_VAL_UINT64:
+        case PB_VAL_INT32:
+        case PB_VAL_FIXED64:
+        case PB_VAL_FIXED32:
+        case PB_VAL_BOOL:
+        case PB_VAL_STRING:
+        case PB_VAL_BYTES:
+        case PB_VAL_UINT32:
+        case PB_VAL_ENUM:
+        case PB_VAL_SFIXED32:
+        case PB_VAL_SFIXED64:
+        case PB_VAL_SINT32:
+        case PB_VAL_SINT64:
+            *out = field_new(msgs, f->name, f->number, (pb_valtype_t) f->type, field_opts_primitive(repeated, f->packed));
+            return NULL;
+        case PB_VAL_MESSAGE:
+            if (desc_string_is(f->type_name, DESC_ANY_TYPE_NAME)) {
+                *out = field_new(msgs, f->name, f->number, PB_VAL_ANY, field_opts_nop());
+                return NULL;
             }
-            switch (type) {
-                case PB_VAL_DOUBLE:
-                case PB_VAL_FLOAT:
-                case PB_VAL_INT64:
-                case PB_VAL_UINT64:
-                case PB_VAL_INT32:
-                case PB_VAL_FIXED64:
-                case PB_VAL_FIXED32:
-                case PB_VAL_BOOL:
-                case PB_VAL_STRING:
-                case PB_VAL_BYTES:
-                case PB_VAL_UINT32:
-                case PB_VAL_ENUM:
-                case PB_VAL_SFIXED32:
-                case PB_VAL_SFIXED64:
-                case PB_VAL_SINT32:
-                case PB_VAL_SINT64:
-                    if (pb_state_get_map_element(state, stack_top - count, string_new("packed"))) {
-                        count++;
-                        packed = pb_state_get_bool(state, stack_top);
-                    }
-                    err = message_append_field(
-                        msg,
-                        field_new(name, tag, (pb_valtype_t) type, field_opts_primitive(repeated, packed))
-                    );
-                    break;
-                case PB_VAL_MESSAGE:
-                    if (pb_state_get_map_element(state, stack_top - count, string_new("msg_name"))) {
-                        count++;
-                        msg_name = pb_state_get_string(state, stack_top);
-                    }
-                    err = message_append_field(
-                        msg,
-                        field_new(name, tag, (pb_valtype_t) type, field_opts_msg(repeated, msg_name))
-                    );
-                    break;
-                case PB_VAL_ANY:
-                    err = message_append_field(
-                        msg,
-                        field_new(name, tag, (pb_valtype_t) type, field_opts_nop())
-                    );
-                    break;
-                case PB_VAL_MAP:
-                    if (pb_state_get_map_element(state, stack_top - count, string_new("val_msg_name"))) {
-                        count++;
-                        val_msg_name = pb_state_get_string(state, stack_top);
-                    }
-                    if (pb_state_get_map_element(state, stack_top - count, string_new("key_type"))) {
-                        count++;
-                        key_type = pb_state_get_uint32(state, stack_top);
-                    }
-                    if (pb_state_get_map_element(state, stack_top - count, string_new("val_type"))) {
-                        count++;
-                        val_type = pb_state_get_uint32(state, stack_top);
-                    }
-                    err = message_append_field(
-                        msg,
-                        field_new(
-                            name,
-                            tag,
-                            (pb_valtype_t) type,
-                            field_opts_map((pb_valtype_t) key_type, (pb_valtype_t) val_type, val_msg_name)
-                        )
-                    );
-                    break;
-                default:
-                    err = pb_error_new(PB_ERR_VAL_TYPE, "unsupported protobuf type %d", type);
-                    break;
+            entry = p->maps ? messages_find(p->maps, f->type_name) : NULL;
+            if (entry) {
+                return desc_map_field_new(msgs, f->name, f->number, entry, out);
             }
-            pb_state_popn(state, (size_t) 1 + count);// array element and fields
+            *out = field_new(msgs, f->name, f->number, PB_VAL_MESSAGE, field_opts_msg(repeated, f->type_name));
+            return NULL;
+        default:
+            return pb_error_new(PB_ERR_VAL_TYPE, "unsupported protobuf type %d", (int) f->type);
+    }
+}
+
+static pb_error_t *desc_read_fields(desc_parser_t *p, pb_buffer_t *type, message_t *msg) {
+    pb_error_t *err = NULL;
+    header_t h;
+    while (desc_next(type, &h, &err)) {
+        if (h.tag != DESC_TYPE_FIELD) {
+            err = desc_skip(type, &h);
+            continue;
+        }
+        desc_field_t f = {};
+        field_t *field = NULL;
+        err = desc_read_field(type, &h, &f);
+        if (!err) {
+            err = desc_field_new(p, &f, &field);
+        }
+        if (!err) {
+            err = message_append_field(msg, field);
         }
-        pb_state_popn(state, 2); // fields an map value
     }
     return err;
 }
 
-pb_error_t *pb_messages_new_descriptor(pb_message_list_t *msgs) {
-    void *state_raw = pb_state_new_raw();
-    pb_state_t *state = pb_state_new(state_raw);
-    pb_error_t *err = pb_state_push_descriptor_meta(state);
+static pb_error_t *desc_read_types(desc_parser_t *p, pb_buffer_t *buf, uint64_t tag);
+
+static pb_error_t *desc_read_type(desc_parser_t *p, pb_buffer_t *buf, header_t *h) {
+    pb_buffer_t type;
+    pb_error_t *err = desc_read_bytes(buf, h, &type);
     if (err) {
-        goto END;
+        return err;
     }
-    err = messages_new_from_state(state, msgs);
 
-    END:
-    pb_state_free_raw(state_raw);
-    pb_state_free(state);
+    // the name and options may follow the fields, they are read first.
+    pb_buffer_t scan = type;
+    pb_string_t name = {};
+    bool map_entry = false;
+    header_t th;
+    while (desc_next(&scan, &th, &err)) {
+        switch (th.tag) {
+            case DESC_TYPE_NAME:
+                err = desc_read_string(&scan, &th, &name);
+                break;
+            case DESC_TYPE_OPTIONS:
+                err = desc_read_bool_option(&scan, &th, DESC_TYPE_OPTIONS_MAP_ENTRY, &map_entry);
+                break;
+            default:
+                err = desc_skip(&scan, &th);
+                break;
+        }
+    }
+    if (err) {
+        return err;
+    }
+
+    size_t mark = desc_push_name(p, name);
+    if (map_entry == p->collect_maps) {
+        message_t *msg = message_new(desc_list(p), desc_name(p));
+        messages_append_msg(desc_list(p), msg);
+        pb_buffer_t fields = type;
+        err = desc_read_fields(p, &fields, msg);
+    }
+    if (!err) {
+        err = desc_read_types(p, &type, DESC_TYPE_NESTED_TYPE);
+    }
+    p->name_len = mark;
     return err;
 }
 
-pb_error_t *pb_messages_parse_pb(pb_message_list_t *desc, pb_buffer_t *buf, pb_message_list_t *msgs) {
-    void *raw_state = pb_state_new_raw();
-    pb_state_t *state = pb_state_new(raw_state);
-    pb_error_t *err = pb_state_push_descriptor_parser(state);
-    if (!err) {
-        err = pb_decode_message(desc, buf, state, string_new(pb_state_descriptor_type()));
+// reads the types with tag in buf, the message types of a file or the nested types of a type.
+static pb_error_t *desc_read_types(desc_parser_t *p, pb_buffer_t *buf, uint64_t tag) {
+    pb_error_t *err = NULL;
+    header_t h;
+    while (desc_next(buf, &h, &err)) {
+        if (h.tag == tag) {
+            err = desc_read_type(p, buf, &h);
+        } else {
+            err = desc_skip(buf, &h);
+        }
+    }
+    return err;
+}
+
+static pb_error_t *desc_read_file(desc_parser_t *p, pb_buffer_t *buf, header_t *h) {
+    pb_buffer_t file;
+    pb_error_t *err = desc_read_bytes(buf, h, &file);
+    if (err) {
+        return err;
+    }
+
+    pb_buffer_t scan = file;
+    pb_string_t package = {};
+    header_t fh;
+    while (desc_next(&scan, &fh, &err)) {
+        if (fh.tag == DESC_FILE_PACKAGE) {
+            err = desc_read_string(&scan, &fh, &package);
+        } else {
+            err = desc_skip(&scan, &fh);
+        }
+    }
+    if (err) {
+        return err;
     }
+
+    size_t mark = desc_push_name(p, package);
+    err = desc_read_types(p, &file, DESC_FILE_MESSAGE_TYPE);
+    p->name_len = mark;
+    return err;
+}
+
+static pb_error_t *desc_read_set(desc_parser_t *p, pb_buffer_t *buf) {
+    pb_buffer_t set = *buf;
+    pb_error_t *err = NULL;
+    header_t h;
+    while (desc_next(&set, &h, &err)) {
+        if (h.tag == DESC_SET_FILE) {
+            err = desc_read_file(p, &set, &h);
+        } else {
+            err = desc_skip(&set, &h);
+        }
+    }
+    return err;
+}
+
+pb_error_t *pb_messages_parse_pb(pb_buffer_t *buf, pb_message_list_t *msgs) {
+    desc_parser_t p = {.msgs=msgs, .maps=messages_new()};
+
+    p.collect_maps = true;
+    pb_error_t *err = desc_read_set(&p, buf);
     if (!err) {
-        err = pb_state_parse_descriptor(state);
+        p.collect_maps = false;
+        err = desc_read_set(&p, buf);
     }
     if (!err) {
-        err = messages_new_from_state(state, msgs);
+        err = messages_link(msgs);
     }
 
-    pb_state_free_raw(raw_state);
-    pb_state_free(state);
+    messages_free(p.maps);
+    free(p.name);
     return err;
 }
 
@@ -162,36 +439,128 @@ static pb_error_t *error_file(const char *fmt, const char *fname) {
     return pb_error_new(PB_ERR_FAIL, fmt, fname, strerror(errno));
 }
 
-pb_error_t *pb_read_file(pb_buffer_t *buf, const char *fname) {
-    FILE *fd = fopen(fname, "r");
+pb_error_t *pb_write_file(pb_buffer_t *buf, const char *fname) {
+    FILE *fd = fopen(fname, "wb");
     if (!fd) {
         return error_file("open file failed %s: %s", fname);
     }
+    pb_string_t str = pb_buffer_payload(buf, pb_buffer_size(buf));
+    pb_error_t *err = NULL;
+    if (fwrite(str.str, 1, str.len, fd) != str.len) {
+        err = error_file("write file failed %s: %s", fname);
+    }
+    if (fclose(fd) != 0 && !err) {
+        err = error_file("write file failed %s: %s", fname);
+    }
+    return err;
+}
 
-    uint8_t b[256];
+// reads the whole file into memory, for the platforms and files that are not mapped.
+static pb_error_t *file_read(pb_file_t *file, const char *fname) {
+    FILE *fd = fopen(fname, "rb");
+    if (!fd) {
+        return error_file("open file failed %s: %s", fname);
+    }
+    // the size is only a hint, files that are not seekable are read until their end.
+    size_t cap = 4096,
+        size = 0;
+    if (fseek(fd, 0, SEEK_END) == 0) {
+        long end = ftell(fd);
+        if (end > 0) {
+            cap = (size_t) end + 1;
+        }
+        rewind(fd);
+    }
+    uint8_t *data = malloc(cap);
     while (!ferror(fd) && !feof(fd)) {
-        size_t n = fread(b, 1, sizeof(b), fd);
-        pb_buffer_write(buf, b, n);
+        if (size == cap) {
+            cap *= 2;
+            data = realloc(data, cap);
+        }
+        size += fread(data + size, 1, cap - size, fd);
     }
     pb_error_t *err = NULL;
     if (ferror(fd)) {
         err = error_file("read file failed %s: %s", fname);
+        free(data);
+    } else {
+        file->data = data;
+        file->size = size;
     }
     fclose(fd);
     return err;
 }
 
-pb_error_t *pb_messages_parse_pbfile(pb_message_list_t *desc, const char *fname, pb_message_list_t *msgs) {
-    FILE *fd = fopen(fname, "r");
-    if (!fd) {
+#if defined(_WIN32)
+
+pb_error_t *pb_file_map(pb_file_t *file, const char *fname) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = false;
+    return file_read(file, fname);
+}
+
+#else
+
+pb_error_t *pb_file_map(pb_file_t *file, const char *fname) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = false;
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
         return error_file("open file failed %s: %s", fname);
     }
+    struct stat st;
+    void *data = MAP_FAILED;
+    // empty and special files are not mapped.
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return file_read(file, fname);
+    }
+    file->data = data;
+    file->size = (size_t) st.st_size;
+    file->mapped = true;
+    return NULL;
+}
+
+#endif
+
+void pb_file_unmap(pb_file_t *file) {
+    if (file->mapped) {
+#if !defined(_WIN32)
+        munmap((void *) file->data, file->size);
+#endif
+    } else {
+        free((void *) file->data);
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = false;
+}
 
-    pb_buffer_t *buf = pb_buffer_new(1024);
-    pb_error_t *err = pb_read_file(buf, fname);
+pb_error_t *pb_read_file(pb_buffer_t *buf, const char *fname) {
+    pb_file_t file;
+    pb_error_t *err = pb_file_map(&file, fname);
     if (!err) {
-        err = pb_messages_parse_pb(desc, buf, msgs);
+        pb_buffer_write(buf, file.data, file.size);
+        pb_file_unmap(&file);
+    }
+    return err;
+}
+
+pb_error_t *pb_messages_parse_pbfile(const char *fname, pb_message_list_t *msgs) {
+    pb_file_t file;
+    pb_error_t *err = pb_file_map(&file, fname);
+    if (err) {
+        return err;
     }
-    pb_buffer_free(buf);
+    // the set is parsed where it is mapped, nothing is kept from it.
+    pb_buffer_t buf;
+    pb_buffer_wrap(&buf, file.data, file.size);
+    err = pb_messages_parse_pb(&buf, msgs);
+    pb_file_unmap(&file);
     return err;
 }
@@ -0,0 +1,718 @@
+// generated by tools/descgen from pb/descriptor.proto, do not edit.
+#include <stddef.h>
+#include "pb.h"
+#include "common.h"
+
+typedef struct {
+    pb_message_list_t list;
+    message_t messages[6];
+    field_t fields[23];
+    rel_t message_fields[18];
+    rel_t by_tag[43];
+    rel_t index[64];
+    char strings[326];
+} desc_schema_t;
+
+#define DESC_REL(from, to) ((rel_t) offsetof(desc_schema_t, to) - (rel_t) offsetof(desc_schema_t, from))
+
+static const desc_schema_t desc_schema = {
+    .list = {
+        .first = DESC_REL(list.first, messages[0]),
+        .last = DESC_REL(list.last, messages[5]),
+        .index = DESC_REL(list.index, index[0]),
+        .index_cap = 64,
+        .count = 6,
+        .any_type_field = {DESC_REL(list.any_type_field.str, strings[288]), 4},
+        .any_value_field = {DESC_REL(list.any_value_field.str, strings[320]), 5},
+        .name_count = 20,
+    },
+    .messages = {
+        [0] = {
+            .name = {DESC_REL(messages[0].name.str, strings[0]), 33},
+            .hash = 0x1c3df63c440ea5d8ULL,
+            .first = DESC_REL(messages[0].first, fields[0]),
+            .last = DESC_REL(messages[0].last, fields[0]),
+            .fields = DESC_REL(messages[0].fields, message_fields[0]),
+            .field_count = 1,
+            .by_tag = DESC_REL(messages[0].by_tag, by_tag[0]),
+            .by_tag_len = 2,
+            .next = DESC_REL(messages[0].next, messages[1]),
+        },
+        [1] = {
+            .name = {DESC_REL(messages[1].name.str, strings[34]), 35},
+            .hash = 0xccdcde26e8ad45eeULL,
+            .first = DESC_REL(messages[1].first, fields[2]),
+            .last = DESC_REL(messages[1].last, fields[8]),
+            .fields = DESC_REL(messages[1].fields, message_fields[1]),
+            .field_count = 5,
+            .by_tag = DESC_REL(messages[1].by_tag, by_tag[2]),
+            .by_tag_len = 13,
+            .next = DESC_REL(messages[1].next, messages[2]),
+        },
+        [2] = {
+            .name = {DESC_REL(messages[2].name.str, strings[70]), 31},
+            .hash = 0x29cf981cf95d9728ULL,
+            .first = DESC_REL(messages[2].first, fields[9]),
+            .last = DESC_REL(messages[2].last, fields[14]),
+            .fields = DESC_REL(messages[2].fields, message_fields[6]),
+            .field_count = 4,
+            .by_tag = DESC_REL(messages[2].by_tag, by_tag[15]),
+            .by_tag_len = 8,
+            .next = DESC_REL(messages[2].next, messages[3]),
+        },
+        [3] = {
+            .name = {DESC_REL(messages[3].name.str, strings[102]), 36},
+            .hash = 0x1a4ea5651c67ee6eULL,
+            .first = DESC_REL(messages[3].first, fields[15]),
+            .last = DESC_REL(messages[3].last, fields[20]),
+            .fields = DESC_REL(messages[3].fields, message_fields[10]),
+            .field_count = 6,
+            .by_tag = DESC_REL(messages[3].by_tag, by_tag[23]),
+            .by_tag_len = 9,
+            .next = DESC_REL(messages[3].next, messages[4]),
+        },
+        [4] = {
+            .name = {DESC_REL(messages[4].name.str, strings[139]), 30},
+            .hash = 0x45a8f2345e9312a4ULL,
+            .first = DESC_REL(messages[4].first, fields[21]),
+            .last = DESC_REL(messages[4].last, fields[21]),
+            .fields = DESC_REL(messages[4].fields, message_fields[16]),
+            .field_count = 1,
+            .by_tag = DESC_REL(messages[4].by_tag, by_tag[32]),
+            .by_tag_len = 8,
+            .next = DESC_REL(messages[4].next, messages[5]),
+        },
+        [5] = {
+            .name = {DESC_REL(messages[5].name.str, strings[170]), 28},
+            .hash = 0x8a51144cd1572d6dULL,
+            .first = DESC_REL(messages[5].first, fields[22]),
+            .last = DESC_REL(messages[5].last, fields[22]),
+            .fields = DESC_REL(messages[5].fields, message_fields[17]),
+            .field_count = 1,
+            .by_tag = DESC_REL(messages[5].by_tag, by_tag[40]),
+            .by_tag_len = 3,
+            .next = 0,
+        },
+    },
+    .fields = {
+        [0] = {
+            .name = {DESC_REL(fields[0].name.str, strings[199]), 4},
+            .tag = 1,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_REPEATED,
+            .repeated = true,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[0].msg_name.str, strings[34]), 35},
+            .value_key = {1, 2, {0x0a}},
+            .packed_key = {1, 2, {0x0a}},
+            .array_element = DESC_REL(fields[0].array_element, fields[1]),
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[0].msg, messages[1]),
+            .ordinal = 0,
+            .name_index = 2,
+            .next = 0,
+        },
+        [1] = {
+            .name = {DESC_REL(fields[1].name.str, strings[34]), 35},
+            .tag = 1,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[1].msg_name.str, strings[34]), 35},
+            .value_key = {1, 2, {0x0a}},
+            .packed_key = {1, 2, {0x0a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[1].msg, messages[1]),
+            .ordinal = 0,
+            .name_index = 0,
+            .next = 0,
+        },
+        [2] = {
+            .name = {DESC_REL(fields[2].name.str, strings[204]), 4},
+            .tag = 1,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x0a}},
+            .packed_key = {1, 2, {0x0a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 0,
+            .name_index = 3,
+            .next = DESC_REL(fields[2].next, fields[3]),
+        },
+        [3] = {
+            .name = {DESC_REL(fields[3].name.str, strings[209]), 7},
+            .tag = 2,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x12}},
+            .packed_key = {1, 2, {0x12}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 1,
+            .name_index = 4,
+            .next = DESC_REL(fields[3].next, fields[4]),
+        },
+        [4] = {
+            .name = {DESC_REL(fields[4].name.str, strings[217]), 10},
+            .tag = 3,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_REPEATED,
+            .repeated = true,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x1a}},
+            .packed_key = {1, 2, {0x1a}},
+            .array_element = DESC_REL(fields[4].array_element, fields[5]),
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 2,
+            .name_index = 5,
+            .next = DESC_REL(fields[4].next, fields[6]),
+        },
+        [5] = {
+            .name = {DESC_REL(fields[5].name.str, strings[228]), 0},
+            .tag = 3,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x1a}},
+            .packed_key = {1, 2, {0x1a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 0,
+            .name_index = 0,
+            .next = 0,
+        },
+        [6] = {
+            .name = {DESC_REL(fields[6].name.str, strings[229]), 12},
+            .tag = 4,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_REPEATED,
+            .repeated = true,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[6].msg_name.str, strings[70]), 31},
+            .value_key = {1, 2, {0x22}},
+            .packed_key = {1, 2, {0x22}},
+            .array_element = DESC_REL(fields[6].array_element, fields[7]),
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[6].msg, messages[2]),
+            .ordinal = 3,
+            .name_index = 6,
+            .next = DESC_REL(fields[6].next, fields[8]),
+        },
+        [7] = {
+            .name = {DESC_REL(fields[7].name.str, strings[70]), 31},
+            .tag = 4,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[7].msg_name.str, strings[70]), 31},
+            .value_key = {1, 2, {0x22}},
+            .packed_key = {1, 2, {0x22}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[7].msg, messages[2]),
+            .ordinal = 0,
+            .name_index = 0,
+            .next = 0,
+        },
+        [8] = {
+            .name = {DESC_REL(fields[8].name.str, strings[242]), 6},
+            .tag = 12,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x62}},
+            .packed_key = {1, 2, {0x62}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 4,
+            .name_index = 7,
+            .next = 0,
+        },
+        [9] = {
+            .name = {DESC_REL(fields[9].name.str, strings[204]), 4},
+            .tag = 1,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x0a}},
+            .packed_key = {1, 2, {0x0a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 0,
+            .name_index = 8,
+            .next = DESC_REL(fields[9].next, fields[10]),
+        },
+        [10] = {
+            .name = {DESC_REL(fields[10].name.str, strings[249]), 5},
+            .tag = 2,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_REPEATED,
+            .repeated = true,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[10].msg_name.str, strings[102]), 36},
+            .value_key = {1, 2, {0x12}},
+            .packed_key = {1, 2, {0x12}},
+            .array_element = DESC_REL(fields[10].array_element, fields[11]),
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[10].msg, messages[3]),
+            .ordinal = 1,
+            .name_index = 9,
+            .next = DESC_REL(fields[10].next, fields[12]),
+        },
+        [11] = {
+            .name = {DESC_REL(fields[11].name.str, strings[102]), 36},
+            .tag = 2,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[11].msg_name.str, strings[102]), 36},
+            .value_key = {1, 2, {0x12}},
+            .packed_key = {1, 2, {0x12}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[11].msg, messages[3]),
+            .ordinal = 0,
+            .name_index = 0,
+            .next = 0,
+        },
+        [12] = {
+            .name = {DESC_REL(fields[12].name.str, strings[255]), 11},
+            .tag = 3,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_REPEATED,
+            .repeated = true,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[12].msg_name.str, strings[70]), 31},
+            .value_key = {1, 2, {0x1a}},
+            .packed_key = {1, 2, {0x1a}},
+            .array_element = DESC_REL(fields[12].array_element, fields[13]),
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[12].msg, messages[2]),
+            .ordinal = 2,
+            .name_index = 10,
+            .next = DESC_REL(fields[12].next, fields[14]),
+        },
+        [13] = {
+            .name = {DESC_REL(fields[13].name.str, strings[70]), 31},
+            .tag = 3,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[13].msg_name.str, strings[70]), 31},
+            .value_key = {1, 2, {0x1a}},
+            .packed_key = {1, 2, {0x1a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[13].msg, messages[2]),
+            .ordinal = 0,
+            .name_index = 0,
+            .next = 0,
+        },
+        [14] = {
+            .name = {DESC_REL(fields[14].name.str, strings[267]), 7},
+            .tag = 7,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[14].msg_name.str, strings[139]), 30},
+            .value_key = {1, 2, {0x3a}},
+            .packed_key = {1, 2, {0x3a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[14].msg, messages[4]),
+            .ordinal = 3,
+            .name_index = 11,
+            .next = 0,
+        },
+        [15] = {
+            .name = {DESC_REL(fields[15].name.str, strings[204]), 4},
+            .tag = 1,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x0a}},
+            .packed_key = {1, 2, {0x0a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 0,
+            .name_index = 12,
+            .next = DESC_REL(fields[15].next, fields[16]),
+        },
+        [16] = {
+            .name = {DESC_REL(fields[16].name.str, strings[275]), 6},
+            .tag = 3,
+            .type = PB_VAL_INT32,
+            .value_wire = WIRE_VARINT,
+            .field_wire = WIRE_VARINT,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 0, {0x18}},
+            .packed_key = {1, 2, {0x1a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 1,
+            .name_index = 13,
+            .next = DESC_REL(fields[16].next, fields[17]),
+        },
+        [17] = {
+            .name = {DESC_REL(fields[17].name.str, strings[282]), 5},
+            .tag = 4,
+            .type = PB_VAL_ENUM,
+            .value_wire = WIRE_VARINT,
+            .field_wire = WIRE_VARINT,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 0, {0x20}},
+            .packed_key = {1, 2, {0x22}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 2,
+            .name_index = 14,
+            .next = DESC_REL(fields[17].next, fields[18]),
+        },
+        [18] = {
+            .name = {DESC_REL(fields[18].name.str, strings[288]), 4},
+            .tag = 5,
+            .type = PB_VAL_ENUM,
+            .value_wire = WIRE_VARINT,
+            .field_wire = WIRE_VARINT,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 0, {0x28}},
+            .packed_key = {1, 2, {0x2a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 3,
+            .name_index = 15,
+            .next = DESC_REL(fields[18].next, fields[19]),
+        },
+        [19] = {
+            .name = {DESC_REL(fields[19].name.str, strings[293]), 9},
+            .tag = 6,
+            .type = PB_VAL_STRING,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 2, {0x32}},
+            .packed_key = {1, 2, {0x32}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 4,
+            .name_index = 16,
+            .next = DESC_REL(fields[19].next, fields[20]),
+        },
+        [20] = {
+            .name = {DESC_REL(fields[20].name.str, strings[267]), 7},
+            .tag = 8,
+            .type = PB_VAL_MESSAGE,
+            .value_wire = WIRE_LENGTH_DELIMITED,
+            .field_wire = WIRE_LENGTH_DELIMITED,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {DESC_REL(fields[20].msg_name.str, strings[170]), 28},
+            .value_key = {1, 2, {0x42}},
+            .packed_key = {1, 2, {0x42}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = DESC_REL(fields[20].msg, messages[5]),
+            .ordinal = 5,
+            .name_index = 17,
+            .next = 0,
+        },
+        [21] = {
+            .name = {DESC_REL(fields[21].name.str, strings[303]), 9},
+            .tag = 7,
+            .type = PB_VAL_BOOL,
+            .value_wire = WIRE_VARINT,
+            .field_wire = WIRE_VARINT,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 0, {0x38}},
+            .packed_key = {1, 2, {0x3a}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 0,
+            .name_index = 18,
+            .next = 0,
+        },
+        [22] = {
+            .name = {DESC_REL(fields[22].name.str, strings[313]), 6},
+            .tag = 2,
+            .type = PB_VAL_BOOL,
+            .value_wire = WIRE_VARINT,
+            .field_wire = WIRE_VARINT,
+            .repeated = false,
+            .packed = false,
+            .map_key_type = 0,
+            .map_value_type = 0,
+            .msg_name = {0, 0},
+            .value_key = {1, 0, {0x10}},
+            .packed_key = {1, 2, {0x12}},
+            .array_element = 0,
+            .map_key = 0,
+            .map_val = 0,
+            .msg = 0,
+            .ordinal = 0,
+            .name_index = 19,
+            .next = 0,
+        },
+    },
+    .message_fields = {
+        DESC_REL(message_fields[0], fields[0]),
+        DESC_REL(message_fields[1], fields[2]),
+        DESC_REL(message_fields[2], fields[3]),
+        DESC_REL(message_fields[3], fields[4]),
+        DESC_REL(message_fields[4], fields[6]),
+        DESC_REL(message_fields[5], fields[8]),
+        DESC_REL(message_fields[6], fields[9]),
+        DESC_REL(message_fields[7], fields[10]),
+        DESC_REL(message_fields[8], fields[12]),
+        DESC_REL(message_fields[9], fields[14]),
+        DESC_REL(message_fields[10], fields[15]),
+        DESC_REL(message_fields[11], fields[16]),
+        DESC_REL(message_fields[12], fields[17]),
+        DESC_REL(message_fields[13], fields[18]),
+        DESC_REL(message_fields[14], fields[19]),
+        DESC_REL(message_fields[15], fields[20]),
+        DESC_REL(message_fields[16], fields[21]),
+        DESC_REL(message_fields[17], fields[22]),
+    },
+    .by_tag = {
+        0,
+        DESC_REL(by_tag[1], fields[0]),
+        0,
+        DESC_REL(by_tag[3], fields[2]),
+        DESC_REL(by_tag[4], fields[3]),
+        DESC_REL(by_tag[5], fields[4]),
+        DESC_REL(by_tag[6], fields[6]),
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        DESC_REL(by_tag[14], fields[8]),
+        0,
+        DESC_REL(by_tag[16], fields[9]),
+        DESC_REL(by_tag[17], fields[10]),
+        DESC_REL(by_tag[18], fields[12]),
+        0,
+        0,
+        0,
+        DESC_REL(by_tag[22], fields[14]),
+        0,
+        DESC_REL(by_tag[24], fields[15]),
+        0,
+        DESC_REL(by_tag[26], fields[16]),
+        DESC_REL(by_tag[27], fields[17]),
+        DESC_REL(by_tag[28], fields[18]),
+        DESC_REL(by_tag[29], fields[19]),
+        0,
+        DESC_REL(by_tag[31], fields[20]),
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        DESC_REL(by_tag[39], fields[21]),
+        0,
+        0,
+        DESC_REL(by_tag[42], fields[22]),
+    },
+    .index = {
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        DESC_REL(index[24], messages[0]),
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        DESC_REL(index[36], messages[4]),
+        0,
+        0,
+        0,
+        DESC_REL(index[40], messages[2]),
+        0,
+        0,
+        0,
+        0,
+        DESC_REL(index[45], messages[5]),
+        DESC_REL(index[46], messages[1]),
+        DESC_REL(index[47], messages[3]),
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+    },
+    .strings = "google.protobuf.FileDescriptorSet\000google.protobuf.FileDescriptorProto\000google.protobuf.DescriptorProto\000google.protobuf.FieldDescriptorProto\000google.protobuf.MessageOptions\000google.protobuf.FieldOptions\000file\000name\000package\000dependency\000\000message_type\000syntax\000field\000nested_type\000options\000number\000label\000type\000type_name\000map_entry\000packed\000value",
+};
+
+pb_message_list_t *pb_messages_descriptor() {
+    return (pb_message_list_t *) &desc_schema.list;
+}
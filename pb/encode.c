@@ -3,166 +3,167 @@
 #include "common.h"
 #include "codec.h"
 
-static size_t write_header(pb_buffer_t *buf, header_t *hdr) {
-    size_t n = 0;
-    n += varint_encode(buf, hdr->tag << 3 | (uint64_t) hdr->wire);
+// at most a key and a length prefix.
+#define HEADER_MAX_BYTECOUNT (2 * VARINT_MAX_BYTECOUNT)
+
+static inline size_t write_key_raw(uint8_t *p, const field_key_t *key) {
+    // a fixed size copy is cheaper than a variable one, the extra bytes are overwritten or ignored.
+    memcpy(p, key->bytes, FIELD_KEY_MAX_BYTECOUNT);
+    return key->len;
+}
+
+static inline size_t write_header_raw(uint8_t *p, header_t *hdr) {
+    size_t n;
+    if (hdr->key) {
+        n = write_key_raw(p, hdr->key);
+    } else {
+        n = varint_write(p, hdr->tag << 3 | (uint64_t) hdr->wire);
+    }
     if (hdr->wire == WIRE_LENGTH_DELIMITED) {
-        n += varint_encode(buf, hdr->len);
+        n += varint_write(p + n, hdr->len);
     }
     return n;
 }
 
-static size_t write_header_swap_last(pb_buffer_t *buf, header_t *h, bool must) {
-    if (!must && h->wire == WIRE_LENGTH_DELIMITED && h->len == 0) {
-        return 0;
-    }
-    size_t n = write_header(buf, h);
-    pb_buffer_swap_last(buf, h->len, n);
+static size_t write_header(pb_buffer_t *buf, header_t *hdr) {
+    size_t n = write_header_raw(pb_buffer_reserve(buf, HEADER_MAX_BYTECOUNT), hdr);
+    pb_buffer_commit(buf, n);
     return n;
 }
 
-static size_t write_raw_string(pb_buffer_t *buf, pb_string_t str, field_t *field, bool must) {
+/**
+ * a length delimited value is written in one pass: its key and a one byte length prefix go first,
+ * then the body. most bodies are shorter than 128 bytes and the prefix is filled in place, a longer
+ * body is moved up by the bytes its length needs beyond the first.
+ */
+typedef struct encoder_t {
+    pb_message_list_t *msgs;
+    pb_buffer_t *buf;
+    pb_state_t *s;
+} encoder_t;
+
+static size_t key_bytecount(header_t *h) {
+    return h->key ? h->key->len : varint_bytecount(h->tag << 3 | (uint64_t) h->wire);
+}
+
+// opens a length delimited value, returns the size of the buffer before its header. the positions
+// are kept as sizes, they do not change when the buffer grows.
+static size_t encoder_begin(encoder_t *e, header_t *h) {
+    size_t head = pb_buffer_size(e->buf);
+    uint8_t *p = pb_buffer_reserve(e->buf, FIELD_KEY_MAX_BYTECOUNT + 1);
+    size_t n = h->key ? write_key_raw(p, h->key) : varint_write(p, h->tag << 3 | (uint64_t) h->wire);
+    p[n] = 0;
+    pb_buffer_commit(e->buf, n + 1);
+    return head;
+}
+
+// closes the value opened at head and writes its length prefix, an empty one is dropped unless it
+// must be written.
+static void encoder_end(encoder_t *e, size_t head, header_t *h, bool must) {
+    pb_buffer_t *buf = e->buf;
+    size_t body = head + key_bytecount(h) + 1,
+        len = pb_buffer_size(buf) - body;
+    if (!must && len == 0) {
+        pb_buffer_truncate(buf, head);
+        return;
+    }
+    size_t extra = varint_bytecount(len) - 1;
+    if (extra) {
+        pb_buffer_grow(buf, extra);
+        uint8_t *p = buf->payload + buf->read + body;
+        memmove(p + extra, p, len);
+        pb_buffer_commit(buf, extra);
+    }
+    varint_write(buf->payload + buf->read + body - 1, len);
+}
+
+static void write_raw_string(encoder_t *e, pb_string_t str, field_t *field, bool must) {
     if (!must && str.len == 0) {
-        return 0;
+        return;
     }
 
-    header_t h;
-    h.tag = field->tag;
+    header_t h = {};
     h.wire = field->value_wire;
     h.len = str.len;
+    h.key = &field->value_key;
 
-    size_t n = write_header(buf, &h);
-    n += pb_buffer_write(buf, (const uint8_t *) str.str, str.len);
-    return n;
+    write_header(e->buf, &h);
+    pb_buffer_write(e->buf, (const uint8_t *) str.str, str.len);
 }
 
-static size_t write_string(pb_buffer_t *buf, pb_state_t *s, int sindex, field_t *field, bool must) {
-    return write_raw_string(buf, pb_state_get_string(s, sindex), field, must);
+static void write_string(encoder_t *e, int sindex, field_t *field, bool must) {
+    write_raw_string(e, pb_state_get_string(e->s, sindex), field, must);
 }
 
-static size_t write_number(pb_buffer_t *buf, pb_state_t *s, int sindex, field_t *field, bool must) {
-    union {
-        uint32_t u32;
-        uint64_t u64;
-    } p;
-    memset(&p, 0, sizeof(p));
-    switch (field->type) {
-        case PB_VAL_SINT32:
-        case PB_VAL_INT32:
-        case PB_VAL_SFIXED32:
-            p.u32 = (uint32_t) pb_state_get_int32(s, sindex);
-            break;
-        case PB_VAL_SINT64:
-        case PB_VAL_INT64:
-        case PB_VAL_SFIXED64:
-            p.u64 = (uint64_t) pb_state_get_int64(s, sindex);
-            break;
-        case PB_VAL_UINT32:
-        case PB_VAL_FIXED32:
-            p.u32 = pb_state_get_uint32(s, sindex);
-            break;
-        case PB_VAL_UINT64:
-        case PB_VAL_FIXED64:
-            p.u64 = pb_state_get_uint64(s, sindex);
-            break;
-        case PB_VAL_FLOAT:
-            p.u32 = float_to_uint32(pb_state_get_float(s, sindex));
-            break;
-        case PB_VAL_DOUBLE:
-            p.u64 = double_to_uint64(pb_state_get_double(s, sindex));
-            break;
-        case PB_VAL_BOOL:
-            p.u32 = (uint32_t) pb_state_get_bool(s, sindex);
-            break;
-        case PB_VAL_ENUM:
-            p.u32 = pb_state_get_uint32(s, sindex);
-            break;
-        default:;
-    }
-    if (!must && p.u32 == 0 && p.u64 == 0) {
-        return 0;
+static void write_number(encoder_t *e, int sindex, field_t *field, bool must) {
+    uint64_t v = field_number_bits(e->s, sindex, field);
+    if (!must && v == 0) {
+        return;
     }
+    size_t width = wire_fixed_bytecount(field->value_wire);
 
+    // reserve the worst case once, then write the key and value straight into the buffer.
+    uint8_t *payload = pb_buffer_reserve(e->buf, FIELD_KEY_MAX_BYTECOUNT + VARINT_MAX_BYTECOUNT);
     size_t n = 0;
     if (field->field_wire != WIRE_LENGTH_DELIMITED) {
-        header_t h = {};
-        h.tag = field->tag;
-        h.wire = field->value_wire;
-        n += write_header(buf, &h);
+        n += write_key_raw(payload, &field->value_key);
     }
-    switch (field->type) {
-        case PB_VAL_SINT32:
-            p.u32 = (uint32_t) bit32_zigzag((int32_t) p.u32);
-        case PB_VAL_INT32:
-        case PB_VAL_UINT32:
-        case PB_VAL_BOOL:
-        case PB_VAL_ENUM:
-            n += varint_encode(buf, (uint64_t) p.u32);
+    switch (width) {
+        case BIT32_BYTECOUNT:
+            n += bit32_write(payload + n, (uint32_t) v);
             break;
-        case PB_VAL_SINT64:
-            p.u64 = (uint64_t) bit64_zigzag((int64_t) p.u64);
-        case PB_VAL_INT64:
-        case PB_VAL_UINT64:
-            n += varint_encode(buf, p.u64);
+        case BIT64_BYTECOUNT:
+            n += bit64_write(payload + n, v);
             break;
-        case PB_VAL_FIXED32:
-        case PB_VAL_SFIXED32:
-        case PB_VAL_FLOAT:
-            n += bit32_encode(buf, p.u32);
-            break;
-        case PB_VAL_FIXED64:
-        case PB_VAL_SFIXED64:
-        case PB_VAL_DOUBLE:
-            n += bit64_encode(buf, p.u64);
+        default:
+            n += varint_write(payload + n, v);
             break;
-        default:;
     }
-    return n;
+    pb_buffer_commit(e->buf, n);
 }
 
-static pb_error_t *encode_all(pb_message_list_t *, pb_buffer_t *, pb_state_t *, field_t *, bool must);
+static pb_error_t *encode_all(encoder_t *e, field_t *field, bool must);
 
-static pb_error_t *encode_message_field(pb_message_list_t *, pb_buffer_t *, pb_state_t *, field_t *);
+static pb_error_t *encode_message_field(encoder_t *e, field_t *field);
 
-static pb_error_t *
-encode_custom_message_no_header(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name);
+static pb_error_t *encode_message_body(encoder_t *e, message_t *msg);
 
-static pb_error_t *encode_repeated(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field) {
+static pb_error_t *encode_repeated(encoder_t *e, field_t *field) {
+    pb_state_t *s = e->s;
     pb_error_t *err = NULL;
     if (field->type == PB_VAL_MAP) {
-        if (field->map_key && field->map_val) {
+        if (field_map_key(field) && field_map_val(field)) {
             header_t h = {};
-            h.tag = field->tag;
             h.wire = field->value_wire;
+            h.key = &field->value_key;
             int key_index = pb_state_stack_top(-1),
                 value_index = pb_state_stack_top(0);
             while (pb_state_iter_map_element_pair(s) && !err) {
                 pb_statetype_t key_type = pb_state_get_type(s, key_index);
                 pb_statetype_t val_type = pb_state_get_type(s, value_index);
-                if (pb_is_state_type_compatible(key_type, field->map_key->type) &&
-                    pb_is_state_type_compatible(val_type, field->map_val->type)) {
+                if (pb_is_state_type_compatible(key_type, field_map_key(field)->type) &&
+                    pb_is_state_type_compatible(val_type, field_map_val(field)->type)) {
 
-                    h.len = pb_buffer_size(buf);
+                    size_t head = encoder_begin(e, &h);
                     if (key_type == PB_STATE_STRING) {
-                        write_string(buf, s, key_index, field->map_key, true);
+                        write_string(e, key_index, field_map_key(field), true);
                     } else {
-                        write_number(buf, s, key_index, field->map_key, true);
+                        write_number(e, key_index, field_map_key(field), true);
                     }
-                    err = encode_all(msgs, buf, s, field->map_val, true);
+                    err = encode_all(e, field_map_val(field), true);
                     if (!err) {
-                        h.len = pb_buffer_size(buf) - h.len;
-                        write_header_swap_last(buf, &h, true);
+                        encoder_end(e, head, &h, true);
                     }
                 }
                 pb_state_pop(s);
             }
         }
-    } else if (field->array_element) {
+    } else if (field_array_element(field)) {
         size_t len = pb_state_get_objlen(s, pb_state_stack_top(0));
         if (len > 0) {
             for (size_t i = 0; i < len && !err; i++) {
                 pb_state_get_array_element(s, pb_state_stack_top(0), (int) i);
-                err = encode_all(msgs, buf, s, field->array_element, true);
+                err = encode_all(e, field_array_element(field), true);
                 pb_state_pop(s);
             }
         }
@@ -170,122 +171,185 @@ static pb_error_t *encode_repeated(pb_message_list_t *msgs, pb_buffer_t *buf, pb
     return err;
 }
 
-static pb_error_t *encode_packed(pb_buffer_t *buf, pb_state_t *s, field_t *field, bool must) {
+static void encode_packed_fixed(encoder_t *e, field_t *field, size_t len, size_t width) {
+    // the payload length is known up front, the header goes first and nothing is moved.
+    header_t h = {};
+    h.wire = field->field_wire;
+    h.key = &field->packed_key;
+    h.len = len * width;
+    write_header(e->buf, &h);
+
+    pb_state_t *s = e->s;
+    uint8_t *payload = pb_buffer_reserve(e->buf, h.len);
+    int sindex = pb_state_stack_top(0);
+    switch (field->type) {
+        case PB_VAL_FLOAT:
+            for (size_t i = 0; i < len; i++, payload += BIT32_BYTECOUNT) {
+                pb_state_get_array_element(s, sindex, (int) i);
+                bit32_write(payload, float_to_uint32(pb_state_get_float(s, sindex)));
+                pb_state_pop(s);
+            }
+            break;
+        case PB_VAL_FIXED32:
+            for (size_t i = 0; i < len; i++, payload += BIT32_BYTECOUNT) {
+                pb_state_get_array_element(s, sindex, (int) i);
+                bit32_write(payload, pb_state_get_uint32(s, sindex));
+                pb_state_pop(s);
+            }
+            break;
+        case PB_VAL_SFIXED32:
+            for (size_t i = 0; i < len; i++, payload += BIT32_BYTECOUNT) {
+                pb_state_get_array_element(s, sindex, (int) i);
+                bit32_write(payload, (uint32_t) pb_state_get_int32(s, sindex));
+                pb_state_pop(s);
+            }
+            break;
+        case PB_VAL_DOUBLE:
+            for (size_t i = 0; i < len; i++, payload += BIT64_BYTECOUNT) {
+                pb_state_get_array_element(s, sindex, (int) i);
+                bit64_write(payload, double_to_uint64(pb_state_get_double(s, sindex)));
+                pb_state_pop(s);
+            }
+            break;
+        case PB_VAL_FIXED64:
+            for (size_t i = 0; i < len; i++, payload += BIT64_BYTECOUNT) {
+                pb_state_get_array_element(s, sindex, (int) i);
+                bit64_write(payload, pb_state_get_uint64(s, sindex));
+                pb_state_pop(s);
+            }
+            break;
+        case PB_VAL_SFIXED64:
+            for (size_t i = 0; i < len; i++, payload += BIT64_BYTECOUNT) {
+                pb_state_get_array_element(s, sindex, (int) i);
+                bit64_write(payload, (uint64_t) pb_state_get_int64(s, sindex));
+                pb_state_pop(s);
+            }
+            break;
+        default:;
+    }
+    pb_buffer_commit(e->buf, h.len);
+}
+
+static pb_error_t *encode_packed(encoder_t *e, field_t *field, bool must) {
+    pb_state_t *s = e->s;
     size_t len = pb_state_get_objlen(s, pb_state_stack_top(0));
     if (!must && len == 0) {
         return NULL;
     }
+    size_t width = wire_fixed_bytecount(field->value_wire);
+    if (width) {
+        encode_packed_fixed(e, field, len, width);
+        return NULL;
+    }
     header_t h = {};
-    h.tag = field->tag;
     h.wire = field->field_wire;
+    h.key = &field->packed_key;
+    size_t head = encoder_begin(e, &h);
     for (size_t i = 0; i < len; i++) {
         pb_state_get_array_element(s, pb_state_stack_top(0), (int) i);
-        h.len += write_number(buf, s, pb_state_stack_top(0), field, true);
+        write_number(e, pb_state_stack_top(0), field, true);
         pb_state_pop(s);
     }
-    write_header_swap_last(buf, &h, must);
+    encoder_end(e, head, &h, must);
     return NULL;
 }
 
-static pb_error_t *encode_any(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, bool must) {
-    header_t h_any = {};
-    h_any.wire = field->value_wire;
-    h_any.tag = field->tag;
-    h_any.len = pb_buffer_size(buf);
-
-    if (!pb_state_get_map_element(s, pb_state_stack_top(0), msgs->any_type_field)) {
+static pb_error_t *encode_any(encoder_t *e, field_t *field, bool must) {
+    pb_state_t *s = e->s;
+    pb_message_list_t *msgs = e->msgs;
+    if (!pb_state_get_map_element_by_name(s, pb_state_stack_top(0), MESSAGES_NAME_ANY_TYPE, rel_string(&msgs->any_type_field))) {
         return NULL;
     }
     pb_error_t *err = NULL;
     pb_string_t str = pb_state_get_string(s, pb_state_stack_top(0));
-    if (!messages_find(msgs, str)) {
+    header_t h_any = {};
+    h_any.wire = field->value_wire;
+    h_any.key = &field->value_key;
+    size_t head = encoder_begin(e, &h_any);
+    message_t *msg = messages_find(msgs, str);
+    if (!msg) {
         err = pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", str.str);
+        goto END;
     }
-    if (err || !pb_state_get_map_element(s, pb_state_stack_top(-1), msgs->any_value_field)) {
+    if (!pb_state_get_map_element_by_name(s, pb_state_stack_top(-1), MESSAGES_NAME_ANY_VALUE, rel_string(&msgs->any_value_field))) {
         goto END;
     }
     field_t tmp = {.tag=1, .value_wire=WIRE_LENGTH_DELIMITED};
-    write_raw_string(buf, str, &tmp, true);
+    field_key_init(&tmp.value_key, tmp.tag, tmp.value_wire);
+    write_raw_string(e, str, &tmp, true);
 
     header_t h = {};
     h.tag = 2;
     h.wire = field->value_wire;
-    h.len = pb_buffer_size(buf);
-    err = encode_custom_message_no_header(msgs, buf, s, str);
-    h.len = pb_buffer_size(buf) - h.len;
+    size_t value_head = encoder_begin(e, &h);
+    err = encode_message_body(e, msg);
     if (!err) {
-        write_header_swap_last(buf, &h, false);
+        encoder_end(e, value_head, &h, false);
     }
     pb_state_pop(s); // pop value
 
     END:
     pb_state_pop(s); // pop type
     if (!err) {
-        h_any.len = pb_buffer_size(buf) - h_any.len;
-        write_header_swap_last(buf, &h_any, must);
+        encoder_end(e, head, &h_any, must);
     }
     return err;
 }
 
-static pb_error_t *
-encode_custom_message(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, bool must) {
+static pb_error_t *encode_custom_message(encoder_t *e, field_t *field, bool must) {
     header_t h = {};
-    h.tag = field->tag;
     h.wire = field->value_wire;
-    h.len = pb_buffer_size(buf);
-    pb_error_t *err = encode_custom_message_no_header(msgs, buf, s, field->opts.msg.name);
+    h.key = &field->value_key;
+    if (!field_msg(field)) {
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", field_msg_name(field).str);
+    }
+    size_t head = encoder_begin(e, &h);
+    pb_error_t *err = encode_message_body(e, field_msg(field));
     if (err) {
         return err;
     }
-    h.len = pb_buffer_size(buf) - h.len;
-    write_header_swap_last(buf, &h, must);
+    encoder_end(e, head, &h, must);
     return NULL;
 }
 
-static pb_error_t *
-encode_length_delimited(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, bool must) {
+static pb_error_t *encode_length_delimited(encoder_t *e, field_t *field, bool must) {
     switch (field->type) {
         case PB_VAL_MESSAGE:
-            return encode_custom_message(msgs, buf, s, field, must);
+            return encode_custom_message(e, field, must);
         case PB_VAL_ANY:
-            return encode_any(msgs, buf, s, field, must);
+            return encode_any(e, field, must);
         case PB_VAL_STRING:
         case PB_VAL_BYTES:
-            write_string(buf, s, pb_state_stack_top(0), field, must);
+            write_string(e, pb_state_stack_top(0), field, must);
             return NULL;
         default:
-            return encode_packed(buf, s, field, must);
+            return encode_packed(e, field, must);
     }
 }
 
-static pb_error_t *encode_all(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field, bool must) {
+static pb_error_t *encode_all(encoder_t *e, field_t *field, bool must) {
     switch (field->field_wire) {
         case WIRE_REPEATED:
-            return encode_repeated(msgs, buf, s, field);
+            return encode_repeated(e, field);
         case WIRE_LENGTH_DELIMITED:
-            return encode_length_delimited(msgs, buf, s, field, must);
+            return encode_length_delimited(e, field, must);
         default:
-            write_number(buf, s, pb_state_stack_top(0), field, must);
+            write_number(e, pb_state_stack_top(0), field, must);
             return NULL;
     }
 }
 
-static pb_error_t *encode_message_field(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, field_t *field) {
-    if (!pb_state_get_map_element(s, pb_state_stack_top(0), field->name)) {
+static pb_error_t *encode_message_field(encoder_t *e, field_t *field) {
+    if (!pb_state_get_map_element_by_name(e->s, pb_state_stack_top(0), field->name_index, field_name(field))) {
         return NULL;
     }
-    pb_error_t *err = encode_all(msgs, buf, s, field, false);
-    pb_state_pop(s);
+    pb_error_t *err = encode_all(e, field, false);
+    pb_state_pop(e->s);
     return err;
 }
 
-static pb_error_t *
-encode_custom_message_no_header(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name) {
-    message_t *msg = messages_find(msgs, msg_name);
-    if (!msg) {
-        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", msg_name.str);
-    }
-    switch (pb_state_get_type(s, pb_state_stack_top(0))) {
+static pb_error_t *encode_message_body(encoder_t *e, message_t *msg) {
+    switch (pb_state_get_type(e->s, pb_state_stack_top(0))) {
         case PB_STATE_NIL:
             return NULL;
         case PB_STATE_OBJECT:
@@ -293,18 +357,26 @@ encode_custom_message_no_header(pb_message_list_t *msgs, pb_buffer_t *buf, pb_st
         default:
             return pb_error_new(PB_ERR_STATE_TYPE, "invalid value type to encode");
     }
+    if (!pb_state_check_stack(e->s, MESSAGE_STACK_SLOTS)) {
+        return pb_error_new(PB_ERR_FAIL, "message nested too deep");
+    }
 
     pb_error_t *err = NULL;
-    field_t *curr = msg->first;
-    while (curr && !err) {
-        err = encode_message_field(msgs, buf, s, curr);
-        curr = curr->next;
+    for (size_t i = 0; i < msg->field_count && !err; i++) {
+        err = encode_message_field(e, message_field(msg, i));
     }
 
     return err;
 }
 
 pb_error_t *pb_encode_message(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name) {
-    pb_error_t *err = encode_custom_message_no_header(msgs, buf, s, msg_name);
+    message_t *msg = messages_find(msgs, msg_name);
+    if (!msg) {
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", msg_name.str);
+    }
+    encoder_t e = {.msgs=msgs, .buf=buf, .s=s};
+    messages_use_names(msgs, s);
+    pb_error_t *err = encode_message_body(&e, msg);
+    pb_state_release_names(s);
     return err;
-}
\ No newline at end of file
+}
@@ -0,0 +1,312 @@
+#include <string.h>
+#include "pb.h"
+#include "common.h"
+#include "codec.h"
+
+/**
+ * the reverse encoder writes a message from its last byte to its first, into the free tail of the
+ * buffer. the length of a body is known once the body is written, so its header is written right
+ * in front of it, with no sizing pass. an empty buffer is then read from the tail, a message
+ * appended to unread bytes is moved behind them once.
+ */
+typedef struct rencoder_t {
+    pb_message_list_t *msgs;
+    pb_buffer_t *buf;
+    pb_state_t *s;
+
+    // bytes written so far, they end at the capacity of the buffer.
+    size_t used;
+} rencoder_t;
+
+// returns the end of the n free bytes in front of the written ones.
+static inline uint8_t *rencoder_reserve(rencoder_t *e, size_t n) {
+    return pb_buffer_reserve_tail(e->buf, e->used, n);
+}
+
+static inline void rwrite_bytes(rencoder_t *e, const uint8_t *p, size_t n) {
+    memcpy(rencoder_reserve(e, n) - n, p, n);
+    e->used += n;
+}
+
+static inline void rwrite_varint(rencoder_t *e, uint64_t v) {
+    size_t n = varint_bytecount(v);
+    varint_write(rencoder_reserve(e, n) - n, v);
+    e->used += n;
+}
+
+static void rwrite_header(rencoder_t *e, header_t *h) {
+    if (h->wire == WIRE_LENGTH_DELIMITED) {
+        rwrite_varint(e, h->len);
+    }
+    if (h->key) {
+        rwrite_bytes(e, h->key->bytes, h->key->len);
+    } else {
+        rwrite_varint(e, h->tag << 3 | (uint64_t) h->wire);
+    }
+}
+
+// writes the header of the body written since mark.
+static void rwrite_header_since(rencoder_t *e, header_t *h, size_t mark, bool must) {
+    h->len = e->used - mark;
+    if (must || h->len > 0) {
+        rwrite_header(e, h);
+    }
+}
+
+static void rwrite_raw_string(rencoder_t *e, pb_string_t str, field_t *field, bool must) {
+    if (!must && str.len == 0) {
+        return;
+    }
+    header_t h = {};
+    h.wire = field->value_wire;
+    h.key = &field->value_key;
+    h.len = str.len;
+    rwrite_bytes(e, (const uint8_t *) str.str, str.len);
+    rwrite_header(e, &h);
+}
+
+static void rwrite_string(rencoder_t *e, int sindex, field_t *field, bool must) {
+    rwrite_raw_string(e, pb_state_get_string(e->s, sindex), field, must);
+}
+
+static void rwrite_number(rencoder_t *e, int sindex, field_t *field, bool must) {
+    uint64_t v = field_number_bits(e->s, sindex, field);
+    if (!must && v == 0) {
+        return;
+    }
+    switch (wire_fixed_bytecount(field->value_wire)) {
+        case BIT32_BYTECOUNT:
+            bit32_write(rencoder_reserve(e, BIT32_BYTECOUNT) - BIT32_BYTECOUNT, (uint32_t) v);
+            e->used += BIT32_BYTECOUNT;
+            break;
+        case BIT64_BYTECOUNT:
+            bit64_write(rencoder_reserve(e, BIT64_BYTECOUNT) - BIT64_BYTECOUNT, v);
+            e->used += BIT64_BYTECOUNT;
+            break;
+        default:
+            rwrite_varint(e, v);
+            break;
+    }
+    if (field->field_wire != WIRE_LENGTH_DELIMITED) {
+        rwrite_bytes(e, field->value_key.bytes, field->value_key.len);
+    }
+}
+
+static pb_error_t *rencode_all(rencoder_t *e, field_t *field, bool must);
+
+static pb_error_t *rencode_message_body(rencoder_t *e, message_t *msg);
+
+static pb_error_t *rencode_repeated(rencoder_t *e, field_t *field) {
+    pb_state_t *s = e->s;
+    pb_error_t *err = NULL;
+    if (field->type == PB_VAL_MAP) {
+        if (field_map_key(field) && field_map_val(field)) {
+            header_t h = {};
+            h.wire = field->value_wire;
+            h.key = &field->value_key;
+            int key_index = pb_state_stack_top(-1),
+                value_index = pb_state_stack_top(0);
+            while (pb_state_iter_map_element_pair(s) && !err) {
+                pb_statetype_t key_type = pb_state_get_type(s, key_index);
+                pb_statetype_t val_type = pb_state_get_type(s, value_index);
+                if (pb_is_state_type_compatible(key_type, field_map_key(field)->type) &&
+                    pb_is_state_type_compatible(val_type, field_map_val(field)->type)) {
+
+                    size_t mark = e->used;
+                    err = rencode_all(e, field_map_val(field), true);
+                    if (!err) {
+                        if (key_type == PB_STATE_STRING) {
+                            rwrite_string(e, key_index, field_map_key(field), true);
+                        } else {
+                            rwrite_number(e, key_index, field_map_key(field), true);
+                        }
+                        rwrite_header_since(e, &h, mark, true);
+                    }
+                }
+                pb_state_pop(s);
+            }
+        }
+    } else if (field_array_element(field)) {
+        size_t len = pb_state_get_objlen(s, pb_state_stack_top(0));
+        for (size_t i = len; i > 0 && !err; i--) {
+            pb_state_get_array_element(s, pb_state_stack_top(0), (int) (i - 1));
+            err = rencode_all(e, field_array_element(field), true);
+            pb_state_pop(s);
+        }
+    }
+    return err;
+}
+
+static void rencode_packed_fixed(rencoder_t *e, field_t *field, size_t len, size_t width) {
+    // the payload is reserved at once and filled front to back.
+    pb_state_t *s = e->s;
+    size_t total = len * width;
+    uint8_t *payload = rencoder_reserve(e, total) - total;
+    int sindex = pb_state_stack_top(0);
+    for (size_t i = 0; i < len; i++, payload += width) {
+        pb_state_get_array_element(s, sindex, (int) i);
+        uint64_t v = field_number_bits(s, sindex, field);
+        if (width == BIT32_BYTECOUNT) {
+            bit32_write(payload, (uint32_t) v);
+        } else {
+            bit64_write(payload, v);
+        }
+        pb_state_pop(s);
+    }
+    e->used += total;
+}
+
+static void rencode_packed(rencoder_t *e, field_t *field, bool must) {
+    pb_state_t *s = e->s;
+    size_t len = pb_state_get_objlen(s, pb_state_stack_top(0));
+    if (!must && len == 0) {
+        return;
+    }
+    header_t h = {};
+    h.wire = field->field_wire;
+    h.key = &field->packed_key;
+    size_t mark = e->used;
+    size_t width = wire_fixed_bytecount(field->value_wire);
+    if (width) {
+        rencode_packed_fixed(e, field, len, width);
+    } else {
+        for (size_t i = len; i > 0; i--) {
+            pb_state_get_array_element(s, pb_state_stack_top(0), (int) (i - 1));
+            rwrite_number(e, pb_state_stack_top(0), field, true);
+            pb_state_pop(s);
+        }
+    }
+    rwrite_header_since(e, &h, mark, must);
+}
+
+static pb_error_t *rencode_any(rencoder_t *e, field_t *field, bool must) {
+    pb_state_t *s = e->s;
+    pb_message_list_t *msgs = e->msgs;
+    if (!pb_state_get_map_element_by_name(s, pb_state_stack_top(0), MESSAGES_NAME_ANY_TYPE, rel_string(&msgs->any_type_field))) {
+        return NULL;
+    }
+    pb_string_t str = pb_state_get_string(s, pb_state_stack_top(0));
+    message_t *msg = messages_find(msgs, str);
+    if (!msg) {
+        pb_state_pop(s);
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", str.str);
+    }
+
+    pb_error_t *err = NULL;
+    size_t mark = e->used;
+    if (pb_state_get_map_element_by_name(s, pb_state_stack_top(-1), MESSAGES_NAME_ANY_VALUE, rel_string(&msgs->any_value_field))) {
+        // the value goes behind the type.
+        header_t h = {};
+        h.tag = 2;
+        h.wire = field->value_wire;
+        size_t value_mark = e->used;
+        err = rencode_message_body(e, msg);
+        if (!err) {
+            rwrite_header_since(e, &h, value_mark, false);
+
+            field_t tmp = {.tag=1, .value_wire=WIRE_LENGTH_DELIMITED};
+            field_key_init(&tmp.value_key, tmp.tag, tmp.value_wire);
+            rwrite_raw_string(e, str, &tmp, true);
+        }
+        pb_state_pop(s); // pop value
+    }
+    pb_state_pop(s); // pop type
+    if (err) {
+        return err;
+    }
+
+    header_t h_any = {};
+    h_any.wire = field->value_wire;
+    h_any.key = &field->value_key;
+    rwrite_header_since(e, &h_any, mark, must);
+    return NULL;
+}
+
+static pb_error_t *rencode_custom_message(rencoder_t *e, field_t *field, bool must) {
+    if (!field_msg(field)) {
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", field_msg_name(field).str);
+    }
+    size_t mark = e->used;
+    pb_error_t *err = rencode_message_body(e, field_msg(field));
+    if (err) {
+        return err;
+    }
+    header_t h = {};
+    h.wire = field->value_wire;
+    h.key = &field->value_key;
+    rwrite_header_since(e, &h, mark, must);
+    return NULL;
+}
+
+static pb_error_t *rencode_length_delimited(rencoder_t *e, field_t *field, bool must) {
+    switch (field->type) {
+        case PB_VAL_MESSAGE:
+            return rencode_custom_message(e, field, must);
+        case PB_VAL_ANY:
+            return rencode_any(e, field, must);
+        case PB_VAL_STRING:
+        case PB_VAL_BYTES:
+            rwrite_string(e, pb_state_stack_top(0), field, must);
+            return NULL;
+        default:
+            rencode_packed(e, field, must);
+            return NULL;
+    }
+}
+
+static pb_error_t *rencode_all(rencoder_t *e, field_t *field, bool must) {
+    switch (field->field_wire) {
+        case WIRE_REPEATED:
+            return rencode_repeated(e, field);
+        case WIRE_LENGTH_DELIMITED:
+            return rencode_length_delimited(e, field, must);
+        default:
+            rwrite_number(e, pb_state_stack_top(0), field, must);
+            return NULL;
+    }
+}
+
+static pb_error_t *rencode_message_field(rencoder_t *e, field_t *field) {
+    if (!pb_state_get_map_element_by_name(e->s, pb_state_stack_top(0), field->name_index, field_name(field))) {
+        return NULL;
+    }
+    pb_error_t *err = rencode_all(e, field, false);
+    pb_state_pop(e->s);
+    return err;
+}
+
+static pb_error_t *rencode_message_body(rencoder_t *e, message_t *msg) {
+    switch (pb_state_get_type(e->s, pb_state_stack_top(0))) {
+        case PB_STATE_NIL:
+            return NULL;
+        case PB_STATE_OBJECT:
+            break;
+        default:
+            return pb_error_new(PB_ERR_STATE_TYPE, "invalid value type to encode");
+    }
+    if (!pb_state_check_stack(e->s, MESSAGE_STACK_SLOTS)) {
+        return pb_error_new(PB_ERR_FAIL, "message nested too deep");
+    }
+
+    // fields are written last to first, so the bytes come out in tag order.
+    pb_error_t *err = NULL;
+    for (size_t i = msg->field_count; i > 0 && !err; i--) {
+        err = rencode_message_field(e, message_field(msg, i - 1));
+    }
+    return err;
+}
+
+pb_error_t *pb_encode_message_reverse(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name) {
+    message_t *msg = messages_find(msgs, msg_name);
+    if (!msg) {
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", msg_name.str);
+    }
+    rencoder_t e = {.msgs=msgs, .buf=buf, .s=s, .used=0};
+    messages_use_names(msgs, s);
+    pb_error_t *err = rencode_message_body(&e, msg);
+    pb_state_release_names(s);
+    if (!err) {
+        pb_buffer_commit_tail(buf, e.used);
+    }
+    return err;
+}
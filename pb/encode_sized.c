@@ -0,0 +1,407 @@
+#include <string.h>
+#include "pb.h"
+#include "common.h"
+#include "codec.h"
+
+// at most a key and a length prefix.
+#define SIZED_HEADER_MAX_BYTECOUNT (FIELD_KEY_MAX_BYTECOUNT + VARINT_MAX_BYTECOUNT)
+
+// the body sizes kept without allocating, deeper or wider messages move them to the heap.
+#define SIZED_STACK_SLOTS 64
+
+/**
+ * the sized encoder walks a message twice: the sizing pass only counts bytes and records the body
+ * size of every length delimited value in visiting order, the writing pass then writes each length
+ * prefix before its body, so no body is ever moved. it walks the values twice where the forward
+ * encoder walks them once, it pays off for large nested bodies, which the forward encoder moves once
+ * per level of nesting.
+ */
+typedef struct sencoder_t {
+    pb_message_list_t *msgs;
+    pb_buffer_t *buf;
+    pb_state_t *s;
+
+    bool sizing;
+    // set when the writing pass sees other values than the sizing pass did, through metamethods.
+    bool changed;
+    size_t *slots;
+    size_t slots_len;
+    size_t slots_cap;
+    size_t slots_next;
+    size_t slots_stack[SIZED_STACK_SLOTS];
+} sencoder_t;
+
+static void sencoder_init(sencoder_t *e, pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s) {
+    e->msgs = msgs;
+    e->buf = buf;
+    e->s = s;
+    e->sizing = true;
+    e->changed = false;
+    e->slots = e->slots_stack;
+    e->slots_len = 0;
+    e->slots_cap = SIZED_STACK_SLOTS;
+    e->slots_next = 0;
+}
+
+static void sencoder_free(sencoder_t *e) {
+    if (e->slots != e->slots_stack) {
+        free(e->slots);
+    }
+}
+
+static size_t sheader_bytecount(header_t *h) {
+    size_t n = h->key ? h->key->len : varint_bytecount(h->tag << 3 | (uint64_t) h->wire);
+    if (h->wire == WIRE_LENGTH_DELIMITED) {
+        n += varint_bytecount(h->len);
+    }
+    return n;
+}
+
+static size_t swrite_header(sencoder_t *e, header_t *h) {
+    uint8_t *p = pb_buffer_reserve(e->buf, SIZED_HEADER_MAX_BYTECOUNT);
+    size_t n;
+    if (h->key) {
+        memcpy(p, h->key->bytes, FIELD_KEY_MAX_BYTECOUNT);
+        n = h->key->len;
+    } else {
+        n = varint_write(p, h->tag << 3 | (uint64_t) h->wire);
+    }
+    if (h->wire == WIRE_LENGTH_DELIMITED) {
+        n += varint_write(p + n, h->len);
+    }
+    pb_buffer_commit(e->buf, n);
+    return n;
+}
+
+// opens a length delimited value and returns its slot. the sizing pass allocates the slot, the
+// writing pass takes the next one and writes the header with the recorded size.
+static size_t sencoder_begin(sencoder_t *e, header_t *h, bool must) {
+    if (e->sizing) {
+        if (e->slots_len == e->slots_cap) {
+            e->slots_cap *= 2;
+            if (e->slots == e->slots_stack) {
+                e->slots = malloc(e->slots_cap * sizeof(size_t));
+                memcpy(e->slots, e->slots_stack, sizeof(e->slots_stack));
+            } else {
+                e->slots = realloc(e->slots, e->slots_cap * sizeof(size_t));
+            }
+        }
+        return e->slots_len++;
+    }
+    if (e->slots_next == e->slots_len) {
+        e->changed = true;
+        h->len = 0;
+        return e->slots_next;
+    }
+    h->len = e->slots[e->slots_next];
+    if (must || h->len > 0) {
+        swrite_header(e, h);
+    }
+    return e->slots_next++;
+}
+
+// closes the value of slot with its body size, adds its bytes to size.
+static void sencoder_end(sencoder_t *e, size_t slot, header_t *h, size_t body, bool must, size_t *size) {
+    if (e->sizing) {
+        e->slots[slot] = body;
+        h->len = body;
+    } else if (h->len != body) {
+        e->changed = true;
+    }
+    if (must || body > 0) {
+        *size += sheader_bytecount(h) + body;
+    }
+}
+
+static void swrite_raw_string(sencoder_t *e, pb_string_t str, field_t *field, bool must, size_t *size) {
+    if (!must && str.len == 0) {
+        return;
+    }
+    header_t h = {};
+    h.wire = field->value_wire;
+    h.key = &field->value_key;
+    h.len = str.len;
+    if (e->sizing) {
+        *size += sheader_bytecount(&h) + str.len;
+        return;
+    }
+    *size += swrite_header(e, &h);
+    *size += pb_buffer_write(e->buf, (const uint8_t *) str.str, str.len);
+}
+
+static void swrite_string(sencoder_t *e, int sindex, field_t *field, bool must, size_t *size) {
+    swrite_raw_string(e, pb_state_get_string(e->s, sindex), field, must, size);
+}
+
+static void swrite_number(sencoder_t *e, int sindex, field_t *field, bool must, size_t *size) {
+    uint64_t v = field_number_bits(e->s, sindex, field);
+    if (!must && v == 0) {
+        return;
+    }
+    bool keyed = field->field_wire != WIRE_LENGTH_DELIMITED;
+    size_t width = wire_fixed_bytecount(field->value_wire);
+    if (e->sizing) {
+        *size += (keyed ? field->value_key.len : 0) + (width ? width : varint_bytecount(v));
+        return;
+    }
+
+    // reserve the worst case once, then write the key and value straight into the buffer.
+    uint8_t *payload = pb_buffer_reserve(e->buf, FIELD_KEY_MAX_BYTECOUNT + VARINT_MAX_BYTECOUNT);
+    size_t n = 0;
+    if (keyed) {
+        memcpy(payload, field->value_key.bytes, FIELD_KEY_MAX_BYTECOUNT);
+        n += field->value_key.len;
+    }
+    switch (width) {
+        case BIT32_BYTECOUNT:
+            n += bit32_write(payload + n, (uint32_t) v);
+            break;
+        case BIT64_BYTECOUNT:
+            n += bit64_write(payload + n, v);
+            break;
+        default:
+            n += varint_write(payload + n, v);
+            break;
+    }
+    pb_buffer_commit(e->buf, n);
+    *size += n;
+}
+
+static pb_error_t *sencode_all(sencoder_t *e, field_t *field, bool must, size_t *size);
+
+static pb_error_t *sencode_message_body(sencoder_t *e, message_t *msg, size_t *size);
+
+static pb_error_t *sencode_repeated(sencoder_t *e, field_t *field, size_t *size) {
+    pb_state_t *s = e->s;
+    pb_error_t *err = NULL;
+    if (field->type == PB_VAL_MAP) {
+        if (field_map_key(field) && field_map_val(field)) {
+            header_t h = {};
+            h.wire = field->value_wire;
+            h.key = &field->value_key;
+            int key_index = pb_state_stack_top(-1),
+                value_index = pb_state_stack_top(0);
+            while (pb_state_iter_map_element_pair(s) && !err) {
+                pb_statetype_t key_type = pb_state_get_type(s, key_index);
+                pb_statetype_t val_type = pb_state_get_type(s, value_index);
+                if (pb_is_state_type_compatible(key_type, field_map_key(field)->type) &&
+                    pb_is_state_type_compatible(val_type, field_map_val(field)->type)) {
+
+                    size_t slot = sencoder_begin(e, &h, true),
+                        body = 0;
+                    if (key_type == PB_STATE_STRING) {
+                        swrite_string(e, key_index, field_map_key(field), true, &body);
+                    } else {
+                        swrite_number(e, key_index, field_map_key(field), true, &body);
+                    }
+                    err = sencode_all(e, field_map_val(field), true, &body);
+                    if (!err) {
+                        sencoder_end(e, slot, &h, body, true, size);
+                    }
+                }
+                pb_state_pop(s);
+            }
+        }
+    } else if (field_array_element(field)) {
+        size_t len = pb_state_get_objlen(s, pb_state_stack_top(0));
+        for (size_t i = 0; i < len && !err; i++) {
+            pb_state_get_array_element(s, pb_state_stack_top(0), (int) i);
+            err = sencode_all(e, field_array_element(field), true, size);
+            pb_state_pop(s);
+        }
+    }
+    return err;
+}
+
+static void sencode_packed_fixed(sencoder_t *e, field_t *field, size_t len, size_t width, size_t *size) {
+    // the payload length is known up front, the sizing pass does not look at the elements.
+    header_t h = {};
+    h.wire = field->field_wire;
+    h.key = &field->packed_key;
+    h.len = len * width;
+    if (e->sizing) {
+        *size += sheader_bytecount(&h) + h.len;
+        return;
+    }
+    *size += swrite_header(e, &h) + h.len;
+
+    pb_state_t *s = e->s;
+    uint8_t *payload = pb_buffer_reserve(e->buf, h.len);
+    int sindex = pb_state_stack_top(0);
+    for (size_t i = 0; i < len; i++, payload += width) {
+        pb_state_get_array_element(s, sindex, (int) i);
+        uint64_t v = field_number_bits(s, sindex, field);
+        if (width == BIT32_BYTECOUNT) {
+            bit32_write(payload, (uint32_t) v);
+        } else {
+            bit64_write(payload, v);
+        }
+        pb_state_pop(s);
+    }
+    pb_buffer_commit(e->buf, h.len);
+}
+
+static void sencode_packed(sencoder_t *e, field_t *field, bool must, size_t *size) {
+    pb_state_t *s = e->s;
+    size_t len = pb_state_get_objlen(s, pb_state_stack_top(0));
+    if (!must && len == 0) {
+        return;
+    }
+    size_t width = wire_fixed_bytecount(field->value_wire);
+    if (width) {
+        sencode_packed_fixed(e, field, len, width, size);
+        return;
+    }
+    header_t h = {};
+    h.wire = field->field_wire;
+    h.key = &field->packed_key;
+    size_t slot = sencoder_begin(e, &h, must),
+        body = 0;
+    for (size_t i = 0; i < len; i++) {
+        pb_state_get_array_element(s, pb_state_stack_top(0), (int) i);
+        swrite_number(e, pb_state_stack_top(0), field, true, &body);
+        pb_state_pop(s);
+    }
+    sencoder_end(e, slot, &h, body, must, size);
+}
+
+static pb_error_t *sencode_any(sencoder_t *e, field_t *field, bool must, size_t *size) {
+    pb_state_t *s = e->s;
+    pb_message_list_t *msgs = e->msgs;
+    if (!pb_state_get_map_element_by_name(s, pb_state_stack_top(0), MESSAGES_NAME_ANY_TYPE, rel_string(&msgs->any_type_field))) {
+        return NULL;
+    }
+    pb_string_t str = pb_state_get_string(s, pb_state_stack_top(0));
+    message_t *msg = messages_find(msgs, str);
+    if (!msg) {
+        pb_state_pop(s);
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", str.str);
+    }
+
+    pb_error_t *err = NULL;
+    header_t h_any = {};
+    h_any.wire = field->value_wire;
+    h_any.key = &field->value_key;
+    size_t slot = sencoder_begin(e, &h_any, must),
+        body = 0;
+    if (pb_state_get_map_element_by_name(s, pb_state_stack_top(-1), MESSAGES_NAME_ANY_VALUE, rel_string(&msgs->any_value_field))) {
+        field_t tmp = {.tag=1, .value_wire=WIRE_LENGTH_DELIMITED};
+        field_key_init(&tmp.value_key, tmp.tag, tmp.value_wire);
+        swrite_raw_string(e, str, &tmp, true, &body);
+
+        header_t h = {};
+        h.tag = 2;
+        h.wire = field->value_wire;
+        size_t value_slot = sencoder_begin(e, &h, false),
+            value_body = 0;
+        err = sencode_message_body(e, msg, &value_body);
+        if (!err) {
+            sencoder_end(e, value_slot, &h, value_body, false, &body);
+        }
+        pb_state_pop(s); // pop value
+    }
+    pb_state_pop(s); // pop type
+    if (!err) {
+        sencoder_end(e, slot, &h_any, body, must, size);
+    }
+    return err;
+}
+
+static pb_error_t *sencode_custom_message(sencoder_t *e, field_t *field, bool must, size_t *size) {
+    if (!field_msg(field)) {
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", field_msg_name(field).str);
+    }
+    header_t h = {};
+    h.wire = field->value_wire;
+    h.key = &field->value_key;
+    size_t slot = sencoder_begin(e, &h, must),
+        body = 0;
+    pb_error_t *err = sencode_message_body(e, field_msg(field), &body);
+    if (err) {
+        return err;
+    }
+    sencoder_end(e, slot, &h, body, must, size);
+    return NULL;
+}
+
+static pb_error_t *sencode_length_delimited(sencoder_t *e, field_t *field, bool must, size_t *size) {
+    switch (field->type) {
+        case PB_VAL_MESSAGE:
+            return sencode_custom_message(e, field, must, size);
+        case PB_VAL_ANY:
+            return sencode_any(e, field, must, size);
+        case PB_VAL_STRING:
+        case PB_VAL_BYTES:
+            swrite_string(e, pb_state_stack_top(0), field, must, size);
+            return NULL;
+        default:
+            sencode_packed(e, field, must, size);
+            return NULL;
+    }
+}
+
+static pb_error_t *sencode_all(sencoder_t *e, field_t *field, bool must, size_t *size) {
+    switch (field->field_wire) {
+        case WIRE_REPEATED:
+            return sencode_repeated(e, field, size);
+        case WIRE_LENGTH_DELIMITED:
+            return sencode_length_delimited(e, field, must, size);
+        default:
+            swrite_number(e, pb_state_stack_top(0), field, must, size);
+            return NULL;
+    }
+}
+
+static pb_error_t *sencode_message_field(sencoder_t *e, field_t *field, size_t *size) {
+    if (!pb_state_get_map_element_by_name(e->s, pb_state_stack_top(0), field->name_index, field_name(field))) {
+        return NULL;
+    }
+    pb_error_t *err = sencode_all(e, field, false, size);
+    pb_state_pop(e->s);
+    return err;
+}
+
+static pb_error_t *sencode_message_body(sencoder_t *e, message_t *msg, size_t *size) {
+    switch (pb_state_get_type(e->s, pb_state_stack_top(0))) {
+        case PB_STATE_NIL:
+            return NULL;
+        case PB_STATE_OBJECT:
+            break;
+        default:
+            return pb_error_new(PB_ERR_STATE_TYPE, "invalid value type to encode");
+    }
+    if (!pb_state_check_stack(e->s, MESSAGE_STACK_SLOTS)) {
+        return pb_error_new(PB_ERR_FAIL, "message nested too deep");
+    }
+
+    pb_error_t *err = NULL;
+    for (size_t i = 0; i < msg->field_count && !err; i++) {
+        err = sencode_message_field(e, message_field(msg, i), size);
+    }
+    return err;
+}
+
+pb_error_t *pb_encode_message_sized(pb_message_list_t *msgs, pb_buffer_t *buf, pb_state_t *s, pb_string_t msg_name) {
+    message_t *msg = messages_find(msgs, msg_name);
+    if (!msg) {
+        return pb_error_new(PB_ERR_MSG_NOT_FOUND, "message not found: %s", msg_name.str);
+    }
+    sencoder_t e;
+    sencoder_init(&e, msgs, buf, s);
+    messages_use_names(msgs, s);
+    size_t size = 0;
+    pb_error_t *err = sencode_message_body(&e, msg, &size);
+    if (!err) {
+        // the message is reserved at once, the writing pass fills it in place.
+        pb_buffer_reserve(buf, size);
+        e.sizing = false;
+        size_t written = 0;
+        err = sencode_message_body(&e, msg, &written);
+        if (!err && (e.changed || written != size)) {
+            err = pb_error_new(PB_ERR_FAIL, "message changed while encoded");
+        }
+    }
+    pb_state_release_names(s);
+    sencoder_free(&e);
+    return err;
+}
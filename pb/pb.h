@@ -53,6 +53,15 @@ pb_buffer_t *pb_buffer_new(size_t cap);
 
 void pb_buffer_readonly(pb_buffer_t *dst, pb_buffer_t *src, size_t size);
 
+// makes dst read the size bytes at payload in place, they must outlive dst and are not freed.
+void pb_buffer_wrap(pb_buffer_t *dst, const uint8_t *payload, size_t size);
+
+// drops the content but keeps the capacity.
+void pb_buffer_reset(pb_buffer_t *buf);
+
+// drops the content after the first size bytes.
+void pb_buffer_truncate(pb_buffer_t *buf, size_t size);
+
 void pb_buffer_free(pb_buffer_t *);
 
 size_t pb_buffer_size(pb_buffer_t *);
@@ -73,6 +82,17 @@ size_t pb_buffer_write(pb_buffer_t *, const uint8_t *, size_t);
 
 uint8_t *pb_buffer_step_write(pb_buffer_t *buf, size_t n);
 
+uint8_t *pb_buffer_reserve(pb_buffer_t *buf, size_t n);
+
+void pb_buffer_commit(pb_buffer_t *buf, size_t n);
+
+// the tail of the free space is written back to front, the used bytes end at the capacity.
+uint8_t *pb_buffer_reserve_tail(pb_buffer_t *buf, size_t used, size_t n);
+
+// appends the used bytes of the tail. an empty buffer is read from the tail in place, the bytes
+// are moved only to follow unread ones.
+void pb_buffer_commit_tail(pb_buffer_t *buf, size_t used);
+
 size_t pb_buffer_swap_last(pb_buffer_t *buf, size_t prev_n, size_t last_n);
 
 /**
@@ -133,9 +153,8 @@ void pb_error_free(pb_error_t *);
  */
 typedef struct pb_state_t pb_state_t;
 
-pb_state_t *pb_state_new(void *);
-
-void pb_state_free(pb_state_t *state);
+// initializes a state over raw, the state is owned by the caller.
+void pb_state_init(pb_state_t *state, void *raw);
 
 typedef enum pb_statetype_t pb_statetype_t;
 
@@ -148,9 +167,10 @@ enum pb_statetype_t {
     PB_STATE_OTHER
 };
 
-void *pb_state_new_raw();
-
-void pb_state_free_raw(void *s);
+#ifdef PB_STATE_INLINE
+// the backend defines these as static inline functions, so they inline into the codecs.
+#include PB_STATE_INLINE
+#else
 
 int pb_state_stack_top(int);
 
@@ -178,6 +198,11 @@ bool pb_state_iter_map_element_pair(pb_state_t *);
 
 void pb_state_get_array_element(pb_state_t *, int sindex, int index);
 
+// raw access skips the metamethods of the maps read, arrays are always read raw.
+void pb_state_set_raw_access(pb_state_t *state, bool raw);
+
+bool pb_state_raw_access(pb_state_t *state);
+
 bool pb_state_get_map_element(pb_state_t *, int sindex, pb_string_t key);
 
 pb_statetype_t pb_state_get_type(pb_state_t *, int);
@@ -208,23 +233,74 @@ void pb_state_push_array(pb_state_t *state);
 
 void pb_state_push_map(pb_state_t *state);
 
+// pushes arrays and maps with room for narr elements and nrec keys.
+void pb_state_push_sized_array(pb_state_t *state, size_t narr);
+
+void pb_state_push_sized_map(pb_state_t *state, size_t nrec);
+
+void pb_state_set_array_element(pb_state_t *state, size_t index);
+
 void pb_state_append_array_element(pb_state_t *state);
 
 void pb_state_set_map_element(pb_state_t *state);
 
+// pushes the current name at index, name itself if there are no current names.
+void pb_state_push_name(pb_state_t *state, size_t index, pb_string_t name);
+
+bool pb_state_get_map_element_by_name(pb_state_t *state, int sindex, size_t index, pb_string_t name);
+
 void pb_state_popn(pb_state_t *state, size_t n);
 
 void pb_state_pop(pb_state_t *);
 
+// makes room for n more values, returns false if the state cannot grow that far.
+bool pb_state_check_stack(pb_state_t *state, size_t n);
+
 bool pb_is_state_type_compatible(pb_statetype_t, pb_valtype_t);
 
-pb_error_t *pb_state_push_descriptor_meta(pb_state_t *state);
+#endif // PB_STATE_INLINE
+
+// defaults of maps, built once and cached by key.
+typedef enum {
+    // absent keys are set to copies of the defaults.
+    PB_DEFAULTS_COPY,
+    // absent keys are set to the defaults, message maps among them are shared and read-only, repeated
+    // and map fields get new empty maps. the state may not catch every write to the shared maps,
+    // callers must not modify them.
+    PB_DEFAULTS_SHARED,
+    // absent keys are left out, a metatable serves the defaults.
+    PB_DEFAULTS_LAZY,
+} pb_defaults_mode_t;
+
+// pushes new defaults of key with room for size fields and caches them, returns false if they are
+// cached already.
+bool pb_state_push_new_defaults(pb_state_t *state, const void *key, size_t size);
+
+// adds the name and the default pushed on the new defaults as the field at ordinal, pops both.
+void pb_state_add_default(pb_state_t *state, size_t ordinal);
+
+// pushes a read-only map serving the defaults of key, an empty one for NULL.
+void pb_state_push_shared_defaults(pb_state_t *state, const void *key);
+
+// pushes the default of repeated and map fields, each message it is set on gets a new empty map.
+void pb_state_push_empty_default(pb_state_t *state);
+
+// sets the cached defaults of key on the map at the top, but for the fields whose ordinal has its bit
+// set in present, which may be NULL.
+void pb_state_set_defaults(pb_state_t *state, const void *key, pb_defaults_mode_t mode, const uint64_t *present);
 
-const char *pb_state_descriptor_type();
+void pb_state_clear_cached_defaults(pb_state_t *state, const void *key);
 
-pb_error_t *pb_state_push_descriptor_parser(pb_state_t *state);
+// names interned once and cached by key, pushed by index without hashing them again.
+// makes the names of key current until they are released, returns true if they are new and count
+// names must be added.
+bool pb_state_use_names(pb_state_t *state, const void *key, size_t count);
 
-pb_error_t *pb_state_parse_descriptor(pb_state_t *state);
+void pb_state_add_name(pb_state_t *state, size_t index, pb_string_t name);
+
+void pb_state_release_names(pb_state_t *state);
+
+void pb_state_clear_cached_names(pb_state_t *state, const void *key);
 
 void pb_state_register_pb_types(pb_state_t *state);
 
@@ -235,14 +311,58 @@ typedef struct pb_message_list_t pb_message_list_t;
 
 pb_error_t *pb_encode_message(pb_message_list_t *, pb_buffer_t *, pb_state_t *, pb_string_t msg_name);
 
+pb_error_t *pb_encode_message_reverse(pb_message_list_t *, pb_buffer_t *, pb_state_t *, pb_string_t msg_name);
+
+pb_error_t *pb_encode_message_sized(pb_message_list_t *, pb_buffer_t *, pb_state_t *, pb_string_t msg_name);
+
 pb_error_t *pb_decode_message(pb_message_list_t *, pb_buffer_t *, pb_state_t *, pb_string_t msg_name);
 
+typedef enum {
+    // absent fields are left out of decoded messages, the defaults of each message type are
+    // served for them from one map shared by all messages of the type.
+    PB_DECODE_LAZY_DEFAULTS = 1 << 0,
+    // absent message and repeated fields share read-only defaults instead of getting new maps.
+    PB_DECODE_SHARED_DEFAULTS = 1 << 1,
+} pb_decode_flag_t;
+
+pb_error_t *pb_decode_message_flags(
+    pb_message_list_t *, pb_buffer_t *, pb_state_t *, pb_string_t msg_name, uint32_t flags);
+
 pb_error_t *pb_read_file(pb_buffer_t *buf, const char *fname);
 
-pb_error_t *pb_messages_parse_pbfile(pb_message_list_t *desc, const char *fname, pb_message_list_t *msgs);
+pb_error_t *pb_write_file(pb_buffer_t *buf, const char *fname);
+
+// the bytes of a file, mapped read-only where the platform allows, read into memory otherwise.
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    bool mapped;
+} pb_file_t;
+
+pb_error_t *pb_file_map(pb_file_t *file, const char *fname);
+
+void pb_file_unmap(pb_file_t *file);
+
+pb_error_t *pb_messages_parse_pbfile(const char *fname, pb_message_list_t *msgs);
+
+// builds msgs from the FileDescriptorSet in buf.
+pb_error_t *pb_messages_parse_pb(pb_buffer_t *buf, pb_message_list_t *msgs);
+
+// the schema of descriptor.proto, compiled in as static data. it is shared and never freed.
+pb_message_list_t *pb_messages_descriptor();
+
+// the schema built from the FileDescriptorSet in buf, shared by every caller in the process that
+// loads the same bytes. it must not be modified, and is freed once each acquire is released.
+pb_error_t *pb_messages_acquire(pb_buffer_t *buf, pb_message_list_t **msgs);
+
+void pb_messages_release(pb_message_list_t *msgs);
 
-pb_error_t *pb_messages_parse_pb(pb_message_list_t *desc, pb_buffer_t *buf, pb_message_list_t *msgs);
+// appends msgs compiled into a flat image to buf. the image is loaded by pb_messages_map without
+// being parsed, only by builds of the same layout.
+pb_error_t *pb_messages_compile(pb_message_list_t *msgs, pb_buffer_t *buf);
 
-pb_error_t *pb_messages_new_descriptor(pb_message_list_t *msgs);
+// the schema in a compiled image, used in place: data must be 8 byte aligned and outlive msgs,
+// which is never freed. the header and every offset are checked, damaged images are rejected.
+pb_error_t *pb_messages_map(const uint8_t *data, size_t size, pb_message_list_t **msgs);
 
 #endif // PB_H
\ No newline at end of file
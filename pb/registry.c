@@ -0,0 +1,139 @@
+#include <string.h>
+#include "pb.h"
+#include "common.h"
+#include "codec.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+
+static SRWLOCK registry_lock = SRWLOCK_INIT;
+
+#define registry_lock_acquire() AcquireSRWLockExclusive(&registry_lock)
+#define registry_lock_release() ReleaseSRWLockExclusive(&registry_lock)
+#else
+#include <pthread.h>
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define registry_lock_acquire() pthread_mutex_lock(&registry_lock)
+#define registry_lock_release() pthread_mutex_unlock(&registry_lock)
+#endif
+
+/**
+ * the registry shares compiled schemas across the process, keyed by a 128 bit hash and the size of
+ * the descriptor bytes. the bytes are not kept, a copy would double the memory of each schema, and
+ * two sets of the same size colliding in 128 bits by chance is not guarded against. schemas are
+ * never modified after they are linked, so any thread may use them without locking, only the
+ * registry itself is guarded.
+ */
+typedef struct registry_key_t {
+    uint64_t hash[2];
+    size_t size;
+} registry_key_t;
+
+typedef struct registry_entry_t {
+    registry_key_t key;
+    size_t refs;
+    pb_message_list_t *msgs;
+    struct registry_entry_t *next;
+} registry_entry_t;
+
+static registry_entry_t *registry_entries = NULL;
+
+static inline uint64_t registry_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// two independent lanes over 8 byte words, the tail is padded with zeros.
+static void registry_key_init(registry_key_t *key, const uint8_t *p, size_t size) {
+    uint64_t a = 0x9e3779b97f4a7c15ULL ^ size,
+        b = 0xc2b2ae3d27d4eb4fULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w = bits_load_le64(p + i);
+        a = (a ^ w) * 0x87c37b91114253d5ULL;
+        a = a << 31 | a >> 33;
+        b = (b ^ w) * 0x4cf5ad432745937fULL;
+        b = (b << 27 | b >> 37) + a;
+    }
+    uint8_t tail[8] = {};
+    memcpy(tail, p + i, size - i);
+    uint64_t w = bits_load_le64(tail);
+    key->hash[0] = registry_mix(a ^ w);
+    key->hash[1] = registry_mix(b + registry_mix(w ^ a));
+    key->size = size;
+}
+
+static registry_entry_t *registry_find(registry_key_t *key) {
+    for (registry_entry_t *e = registry_entries; e; e = e->next) {
+        if (e->key.size == key->size && e->key.hash[0] == key->hash[0] && e->key.hash[1] == key->hash[1]) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+pb_error_t *pb_messages_acquire(pb_buffer_t *buf, pb_message_list_t **msgs) {
+    registry_key_t key;
+    registry_key_init(&key, buf->payload + buf->read, pb_buffer_size(buf));
+
+    registry_lock_acquire();
+    registry_entry_t *e = registry_find(&key);
+    if (e) {
+        e->refs++;
+        *msgs = e->msgs;
+    }
+    registry_lock_release();
+    if (e) {
+        return NULL;
+    }
+
+    // parsed without the lock, when another thread registers the same schema meanwhile, it wins.
+    pb_message_list_t *parsed = messages_new();
+    pb_error_t *err = pb_messages_parse_pb(buf, parsed);
+    if (err) {
+        messages_free(parsed);
+        return err;
+    }
+    registry_lock_acquire();
+    e = registry_find(&key);
+    if (!e) {
+        e = calloc(1, sizeof(registry_entry_t));
+        e->key = key;
+        e->msgs = parsed;
+        e->next = registry_entries;
+        registry_entries = e;
+        parsed = NULL;
+    }
+    e->refs++;
+    *msgs = e->msgs;
+    registry_lock_release();
+    if (parsed) {
+        messages_free(parsed);
+    }
+    return NULL;
+}
+
+void pb_messages_release(pb_message_list_t *msgs) {
+    registry_lock_acquire();
+    registry_entry_t **link = &registry_entries;
+    while (*link && (*link)->msgs != msgs) {
+        link = &(*link)->next;
+    }
+    registry_entry_t *e = *link;
+    if (e && --e->refs == 0) {
+        *link = e->next;
+    } else {
+        e = NULL;
+    }
+    registry_lock_release();
+    if (e) {
+        messages_free(e->msgs);
+        free(e);
+    }
+}
@@ -0,0 +1,45 @@
+-- encoding and decoding flat messages allocates no C heap once warmed up, the lua objects they
+-- create are allocated by lua.
+local pb = require('pblua')
+local u = pb.loadfile('build/testout/proto.pb')
+
+local flat = {
+    String = 'flat',
+    Int32 = -1,
+    Uint64 = 2,
+    Double = 0.5,
+    Bool = true,
+    Bytes = '\0\1',
+    Int32s = { 1, 2, 3 },
+    Strings = { 'a', 'b' },
+}
+local encoded = u:encode('test.User', flat)
+local out = pb.buffer()
+
+local steps = {
+    { 'encode', function() u:encode('test.User', flat) end },
+    { 'encode_into', function()
+        out:reset()
+        u:encode_into(out, 'test.User', flat)
+    end },
+    { 'decode', function() u:decode('test.User', encoded) end },
+}
+for _, encoder in ipairs({ 'forward', 'reverse' }) do
+    for _, defaults in ipairs({ 'eager', 'shared', 'lazy' }) do
+        u:setencoder(encoder)
+        u:setdefaults(defaults)
+        for _, step in ipairs(steps) do
+            local name, f = step[1], step[2]
+            f()
+            alloc_counting(true)
+            for _ = 1, 100 do
+                f()
+            end
+            alloc_counting(false)
+            assert(alloc_count() == 0, string.format('%s %s %s: %d heap allocations mismatch',
+                encoder, defaults, name, alloc_count()))
+        end
+    end
+end
+u:setencoder('forward')
+u:setdefaults('eager')
@@ -0,0 +1,156 @@
+local pb = require('pblua')
+local u = pb.loadfile('build/testout/proto.pb')
+
+local function bench(name, n, f)
+    local start = os.clock()
+    for i = 1, n do
+        f()
+    end
+    print(string.format('%-40s %10.2f us/op', name, (os.clock() - start) * 1e6 / n))
+end
+
+local function check_array(name, got, expect)
+    assert(#got == #expect, name .. ': length mismatch')
+    for i = 1, #expect do
+        assert(got[i] == expect[i], name .. ': element mismatch at ' .. i)
+    end
+end
+
+--- packed fixed width arrays
+local packed = {
+    Floats = {},
+    Doubles = {},
+    Fixed32s = {},
+    Sfixed64s = {},
+}
+for i = 1, 4096 do
+    packed.Floats[i] = i + 0.5
+    packed.Doubles[i] = i * 0.25 - 100
+    packed.Fixed32s[i] = i * 7
+    packed.Sfixed64s[i] = -i * 3
+end
+
+local packed_encoded = u:encode('bench.Packed', packed)
+local packed_decoded = u:decode('bench.Packed', packed_encoded)
+for k, v in pairs(packed) do
+    check_array(k, packed_decoded[k], v)
+end
+bench('encode packed fixed 4x4096', 200, function()
+    u:encode('bench.Packed', packed)
+end)
+bench('decode packed fixed 4x4096', 200, function()
+    u:decode('bench.Packed', packed_encoded)
+end)
+
+--- packed varint arrays
+local ids = {
+    Int32s = {},
+    Sint64s = {},
+    Ids = {},
+}
+for i = 1, 4096 do
+    ids.Int32s[i] = i % 100
+    ids.Sint64s[i] = (i % 2 == 0) and i * 1000 or -i * 1000
+    ids.Ids[i] = 1000000000 + i * 977
+end
+
+local ids_encoded = u:encode('bench.Packed', ids)
+local ids_decoded = u:decode('bench.Packed', ids_encoded)
+for k, v in pairs(ids) do
+    check_array(k, ids_decoded[k], v)
+end
+bench('decode packed varint 3x4096', 200, function()
+    u:decode('bench.Packed', ids_encoded)
+end)
+
+--- nested messages, 5 levels
+local function make_node(depth, index, width, payload)
+    local node = {Name = 'node-' .. depth .. '-' .. index, Value = depth * 1000 + index}
+    if depth < 5 then
+        node.Children = {}
+        for i = 1, width do
+            node.Children[i] = make_node(depth + 1, i, width, payload)
+        end
+    else
+        node.Name = node.Name .. payload
+    end
+    return node
+end
+
+local function check_node(got, expect)
+    assert(got.Name == expect.Name, 'node name mismatch')
+    assert(got.Value == expect.Value, 'node value mismatch')
+    local got_children, expect_children = got.Children or {}, expect.Children or {}
+    assert(#got_children == #expect_children, 'node children mismatch')
+    for i = 1, #expect_children do
+        check_node(got_children[i], expect_children[i])
+    end
+end
+
+local trees = {
+    {'nested 5 levels x4', make_node(1, 1, 4, '')},
+    {'nested 5 levels x1 64KB', make_node(1, 1, 1, string.rep('x', 65536))},
+}
+for _, t in ipairs(trees) do
+    local name, tree = t[1], t[2]
+    local tree_encoded = u:encode('bench.Node', tree)
+    check_node(u:decode('bench.Node', tree_encoded), tree)
+    for _, encoder in ipairs({ 'forward', 'reverse', 'sized' }) do
+        u:setencoder(encoder)
+        assert(u:encode('bench.Node', tree) == tree_encoded or encoder == 'reverse', encoder .. ': encoded tree mismatch')
+        bench('encode ' .. name .. ' ' .. encoder, 200, function()
+            u:encode('bench.Node', tree)
+        end)
+    end
+    u:setencoder('forward')
+    bench('decode ' .. name, 200, function()
+        u:decode('bench.Node', tree_encoded)
+    end)
+end
+
+--- repeated fields with a key per element
+local records = {Names = {}, Items = {}, Values = {}}
+for i = 1, 4096 do
+    records.Names[i] = 'name-' .. i
+    records.Values[i] = i * 1000
+end
+for i = 1, 1024 do
+    records.Items[i] = {Name = 'item-' .. i, Value = i}
+end
+local records_encoded = u:encode('bench.Records', records)
+local records_decoded = u:decode('bench.Records', records_encoded)
+check_array('Names', records_decoded.Names, records.Names)
+check_array('Values', records_decoded.Values, records.Values)
+assert(#records_decoded.Items == #records.Items, 'Items: length mismatch')
+for _, access in ipairs({'meta', 'raw'}) do
+    u:setaccess(access)
+    assert(u:encode('bench.Records', records) == records_encoded, access .. ': encoded records mismatch')
+    bench('encode repeated records ' .. access, 100, function()
+        u:encode('bench.Records', records)
+    end)
+end
+u:setaccess('meta')
+bench('decode repeated records', 100, function()
+    u:decode('bench.Records', records_encoded)
+end)
+
+--- sparse messages, one field set out of many
+local sparse_encoded = u:encode('test.User', {String = 'sparse', Msg = {First = 'F'}})
+for _, defaults in ipairs({'eager', 'shared', 'lazy'}) do
+    u:setdefaults(defaults)
+    bench('decode sparse ' .. defaults, 20000, function()
+        u:decode('test.User', sparse_encoded)
+    end)
+end
+u:setdefaults('eager')
+
+--- small messages into a reused buffer
+local request = {String = 'request', Int32 = 42, Msg = {First = 'F', Last = 'L'}}
+bench('encode small', 100000, function()
+    u:encode('test.User', request)
+end)
+local out = pb.buffer()
+bench('encode_into small', 100000, function()
+    out:reset()
+    u:encode_into(out, 'test.User', request)
+end)
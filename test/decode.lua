@@ -10,6 +10,170 @@ u:decode('test.User', content)
 end
 local obj = u:decode('test.User', content)
 
+local function deep_equal(a, b)
+    if type(a) ~= 'table' or type(b) ~= 'table' then
+        return a == b
+    end
+    for k, v in pairs(a) do
+        if not deep_equal(v, b[k]) then
+            return false
+        end
+    end
+    for k in pairs(b) do
+        if a[k] == nil then
+            return false
+        end
+    end
+    return true
+end
+
+-- the decoded object encodes to the same message with either encoder.
+local forward = u:encode('test.User', obj)
+u:setencoder('reverse')
+local reverse = u:encode('test.User', obj)
+u:setencoder('forward')
+assert(#forward == #reverse, 'reverse encoder: length mismatch')
+assert(deep_equal(u:decode('test.User', forward), u:decode('test.User', reverse)), 'reverse encoder: round trip mismatch')
+
+-- shared and lazy defaults serve the same values, absent fields come from the cached defaults.
+local sparse = u:encode('test.User', { String = "s", Msg = { First = "F" } })
+for _, data in ipairs({ content, sparse, '' }) do
+    local eager = u:decode('test.User', data)
+    for _, defaults in ipairs({ 'shared', 'lazy' }) do
+        u:setdefaults(defaults)
+        local decoded = u:decode('test.User', data)
+        u:setdefaults('eager')
+        assert(deep_equal(eager, decoded), defaults .. ' defaults: mismatch')
+    end
+end
+u:setdefaults('shared')
+local shared, other = u:decode('test.User', ''), u:decode('test.User', '')
+u:setdefaults('eager')
+assert(shared.Msg == other.Msg and shared.Msg.First == '', 'shared defaults: nested message not shared')
+assert(not pcall(function() shared.Msg.First = 'x' end), 'shared defaults: nested message writable')
+assert(getmetatable(shared.Msg) == false, 'shared defaults: metatable reachable')
+-- repeated and map fields get their own empty tables, changing them changes no later decode.
+u:setdefaults('shared')
+table.insert(shared.Int32s, 5)
+shared.Int32map[1] = 'x'
+local nested = u:decode('deep.M0', '')
+table.insert(nested.child.list, {})
+other, nested = u:decode('test.User', ''), u:decode('deep.M0', '')
+u:setdefaults('eager')
+assert(#other.Int32s == 0 and next(other.Int32map) == nil, 'shared defaults: repeated field modified')
+assert(#nested.list == 0 and #nested.child.list == 0, 'shared defaults: nested repeated field modified')
+local eager = u:decode('test.User', '')
+assert(eager.Msg ~= u:decode('test.User', '').Msg, 'eager defaults: nested message shared')
+eager.Msg.First = 'x'
+assert(u:decode('test.User', '').Msg.First == '', 'eager defaults: nested message modified')
+u:setdefaults('lazy')
+local lazy, other = u:decode('test.User', sparse), u:decode('test.User', content)
+u:setdefaults('eager')
+assert(rawget(lazy, 'Int32') == nil and lazy.Int32 == 0, 'lazy defaults: absent field')
+assert(rawget(lazy.Msg, 'Last') == nil and lazy.Msg.Last == '', 'lazy defaults: absent nested field')
+assert(getmetatable(lazy) == getmetatable(other), 'lazy defaults: metatable not shared')
+u:setdefaults('lazy')
+table.insert(lazy.Int32s, 5)
+nested = u:decode('deep.M0', '')
+table.insert(nested.list, {})
+other, nested = u:decode('test.User', sparse), u:decode('deep.M0', '')
+u:setdefaults('eager')
+assert(rawget(lazy, 'Int32s') == lazy.Int32s and lazy.Int32s[1] == 5, 'lazy defaults: repeated field not kept')
+assert(#other.Int32s == 0 and #nested.list == 0, 'lazy defaults: repeated field modified')
+
+-- messages nested deeper than the Lua stack a call starts with build their defaults and round trip.
+local chain, cur = {}, nil
+cur = chain
+for i = 0, 30 do
+    cur.v, cur.s, cur.list, cur.child = i, 's' .. i, { { v = i } }, {}
+    cur = cur.child
+end
+cur.v = 31
+local function depth(m)
+    local d = 0
+    while m do
+        d, m = d + 1, m.child
+    end
+    return d
+end
+for _, defaults in ipairs({ 'eager', 'shared', 'lazy' }) do
+    u:setdefaults(defaults)
+    assert(depth(u:decode('deep.M0', '')) == 32, defaults .. ' defaults: deep depth mismatch')
+    for _, encoder in ipairs({ 'forward', 'reverse', 'sized' }) do
+        u:setencoder(encoder)
+        local decoded = u:decode('deep.M0', u:encode('deep.M0', chain))
+        u:setencoder('forward')
+        assert(depth(decoded) == 32 and decoded.child.list[1].v == 1, defaults .. ' defaults, ' .. encoder ..
+            ' encoder: deep round trip mismatch')
+    end
+    u:setdefaults('eager')
+end
+
+-- data nested deeper than the stack can grow fails to encode and decode.
+local node, bytes = {}, ''
+cur = node
+for _ = 1, 20000 do
+    cur.Children = { {} }
+    cur = cur.Children[1]
+    local len, n = '', #bytes
+    repeat
+        len, n = len .. string.char(n % 128 + (n >= 128 and 128 or 0)), math.floor(n / 128)
+    until n == 0
+    bytes = '\26' .. len .. bytes
+end
+local encoded, err = u:encode('bench.Node', node)
+assert(not encoded and err == 'message nested too deep', 'deep data: encoded')
+local decoded, err = u:decode('bench.Node', bytes)
+assert(not decoded and err == 'message nested too deep', 'deep data: decoded')
+
+-- nested messages and map entries longer than the input fail to decode.
+for _, data in ipairs({ '\146\2\16\10\1F', '\130\2\16\8\1', '\162\2\16\10\4test' }) do
+    local truncated, err = u:decode('test.User', data)
+    assert(not truncated and err == 'unexpected EOF', 'truncated nested message decoded')
+end
+
+-- the compiled-in descriptor schema decodes .pb files.
+fd = io.open('build/testout/proto.pb')
+local set = pb.descriptor:decode('google.protobuf.FileDescriptorSet', fd:read('*a'))
+fd:close()
+local user
+for _, file in ipairs(set.file) do
+    for _, t in ipairs(file.message_type) do
+        if file.package == 'test' and t.name == 'User' then
+            user = t
+        end
+    end
+end
+assert(user and #user.field == 37, 'descriptor: test.User not found')
+assert(user.field[1].name == 'String' and user.field[1].number == 1, 'descriptor: field mismatch')
+assert(user.nested_type[2].options.map_entry, 'descriptor: map entry option')
+
+-- a set loaded from a string decodes as the one loaded from its file.
+fd = io.open('build/testout/proto.pb', 'rb')
+local fromstring = pb.loadstring(fd:read('*a'))
+fd:close()
+assert(deep_equal(fromstring:decode('test.User', content), obj), 'loadstring: decode mismatch')
+assert(not pb.loadfile('build/testout/missing.pb'), 'loadfile: missing file loaded')
+
+-- a compiled schema decodes and encodes as the one it is compiled from.
+assert(pb.compile('build/testout/proto.pb', 'build/testout/proto.pbc'), 'compile failed')
+local compiled = pb.loadcompiled('build/testout/proto.pbc')
+assert(deep_equal(compiled:decode('test.User', content), obj), 'compiled schema: decode mismatch')
+assert(compiled:encode('test.User', obj) == forward, 'compiled schema: encode mismatch')
+local missing, err = pb.loadcompiled('build/testout/proto.pb')
+assert(not missing and err, 'compiled schema: descriptor set loaded as compiled')
+-- a rejected file is unmapped at once, where the maps are listed.
+local maps = io.open('/proc/self/maps')
+if maps then
+    maps:close()
+    for _ = 1, 4 do
+        pb.loadcompiled('build/testout/proto.pb')
+    end
+    maps = io.open('/proc/self/maps')
+    assert(not maps:read('*a'):find('proto.pb\n', 1, true), 'compiled schema: rejected file still mapped')
+    maps:close()
+end
+
 local encode
 
 local escape_char_map = {
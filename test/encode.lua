@@ -151,10 +151,79 @@ end
 
 local pb = require('pblua')
 local u = pb.loadfile('build/testout/proto.pb')
-for i = 0,200000 do
-    u:encode('test.User', obj)
+local function deep_equal(a, b)
+    if type(a) ~= 'table' or type(b) ~= 'table' then
+        return a == b
+    end
+    for k, v in pairs(a) do
+        if not deep_equal(v, b[k]) then
+            return false
+        end
+    end
+    for k in pairs(b) do
+        if a[k] == nil then
+            return false
+        end
+    end
+    return true
 end
+
+local expect = u:decode('test.User', u:encode('test.User', obj))
+for _, encoder in ipairs({ 'forward', 'reverse', 'sized' }) do
+    u:setencoder(encoder)
+    local start = os.clock()
+    for i = 0,200000 do
+        u:encode('test.User', obj)
+    end
+    print(string.format('encode %s: %.3fs', encoder, os.clock() - start))
+
+    assert(deep_equal(expect, u:decode('test.User', u:encode('test.User', obj))), encoder .. ': round trip mismatch')
+end
+u:setencoder('forward')
 local content = u:encode('test.User', obj)
+u:setencoder('sized')
+assert(u:encode('test.User', obj) == content, 'sized: encoded bytes mismatch')
+-- values served differently to the sizing and the writing pass fail to encode.
+local calls = 0
+local changing = setmetatable({}, { __index = function(_, k)
+    if k == 'String' then
+        calls = calls + 1
+        return string.rep('x', calls)
+    end
+end })
+local encoded, err = u:encode('test.User', changing)
+assert(not encoded and err == 'message changed while encoded', 'sized: changed message encoded')
+u:setencoder('forward')
+
+-- buffers append encoded messages and keep their capacity.
+local out = pb.buffer()
+assert(not pcall(pb.buffer, -1), 'buffer: negative capacity accepted')
+for _, encoder in ipairs({ 'forward', 'reverse', 'sized' }) do
+    u:setencoder(encoder)
+    out:reset()
+    assert(u:encode_into(out, 'test.User', obj) == out, encoder .. ': encode_into result mismatch')
+    assert(u:encode_into(out, 'test.User', obj) == out, encoder .. ': encode_into result mismatch')
+    assert(out:len() == 2 * #content and #out == out:len(), encoder .. ': buffer length mismatch')
+    assert(out:tostring() == u:encode('test.User', obj):rep(2), encoder .. ': buffer content mismatch')
+    assert(type(out:pointer()) == 'userdata', encoder .. ': buffer pointer mismatch')
+    assert(u:encode_into(out, 'test.User', { Any = { type = 'test.Unknown', value = {} } }) == nil,
+        encoder .. ': encode_into error mismatch')
+    assert(out:len() == 2 * #content, encoder .. ': failed encode_into appended')
+end
+u:setencoder('forward')
+
+-- a buffer a message was encoded into in reverse takes the next ones forward.
+for _, cap in ipairs({ #content, 4 * #content }) do
+    local mixed = pb.buffer(cap)
+    u:setencoder('reverse')
+    u:encode_into(mixed, 'test.User', obj)
+    local reverse = u:encode('test.User', obj)
+    u:setencoder('forward')
+    for _ = 1, 3 do
+        u:encode_into(mixed, 'test.User', obj)
+    end
+    assert(mixed:tostring() == reverse .. content:rep(3), 'mixed encoders: buffer content mismatch')
+end
 local io = require('io')
 local fd = io.open('build/testout/pb.encode', 'w')
 fd:write(content)
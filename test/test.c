@@ -1,8 +1,12 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
 #include "../pb/pb.h"
 #include "../pb/codec.h"
+#include "../pb/common.h"
 #include <lua.h>
 #include <lualib.h>
 #include <lauxlib.h>
@@ -22,6 +26,29 @@ void test_buffer() {
     assert(strcmp(read, "221112") == 0);
 
     pb_buffer_free(buf);
+
+    // wrapped bytes are read in place.
+    pb_buffer_t wrapped;
+    pb_buffer_wrap(&wrapped, (const uint8_t *) str, strlen(str));
+    assert(pb_buffer_size(&wrapped) == strlen(str));
+    const uint8_t *stepped = pb_buffer_step_read(&wrapped, 3);
+    assert(stepped == (const uint8_t *) str);
+    assert(pb_buffer_size(&wrapped) == 3);
+
+    // tail bytes are read in place from an empty buffer, appended ones follow the unread bytes.
+    buf = pb_buffer_new(16);
+    memcpy(pb_buffer_reserve_tail(buf, 0, 3) - 3, "abc", 3);
+    pb_buffer_commit_tail(buf, 3);
+    pb_string_t payload = pb_buffer_payload(buf, pb_buffer_size(buf));
+    assert(payload.len == 3 && payload.str == (const char *) buf->payload + 13);
+    for (int i = 0; i < 8; i++) {
+        memcpy(pb_buffer_reserve_tail(buf, 0, 1) - 1, "d", 1);
+        pb_buffer_commit_tail(buf, 1);
+    }
+    payload = pb_buffer_payload(buf, pb_buffer_size(buf));
+    assert(payload.len == 11 && memcmp(payload.str, "abcdddddddd", 11) == 0);
+    assert(buf->cap == 16);
+    pb_buffer_free(buf);
 }
 
 void test_encoding() {
@@ -52,9 +79,585 @@ void test_encoding() {
     assert(zig64 == bit64_dezigzag(bit64_zigzag(zig64)));
 }
 
+static const uint64_t varint_samples[] = {
+    0, 1, 127, 128, 300, 16383, 16384,
+    (1ULL << 32), (1ULL << 35) - 1, (1ULL << 56) - 1, (1ULL << 56), (1ULL << 63) - 1, UINT64_MAX
+};
+
+void test_varint() {
+    const size_t count = sizeof(varint_samples) / sizeof(varint_samples[0]);
+    // the fast path needs at least 10 readable bytes, the slow path handles the rest.
+    for (size_t pad = 0; pad <= 10; pad += 10) {
+        pb_buffer_t *buf = pb_buffer_new(1024);
+        for (size_t i = 0; i < count; i++) {
+            size_t n = varint_encode(buf, varint_samples[i]);
+            assert(n == varint_bytecount(varint_samples[i]));
+        }
+        for (size_t i = 0; i < pad; i++) {
+            varint_encode(buf, 0);
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint64_t val = 0;
+            size_t size = 0;
+            pb_error_t *err = varint_decode(buf, &val, &size);
+            assert(!err);
+            assert(val == varint_samples[i]);
+        }
+        pb_buffer_free(buf);
+    }
+
+    pb_buffer_t *buf = pb_buffer_new(1024);
+    const uint8_t overflow[] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+    for (size_t n = 11; n <= sizeof(overflow); n += sizeof(overflow) - 11) {
+        pb_buffer_write(buf, overflow, n);
+        uint64_t val;
+        pb_error_t *err = varint_decode(buf, &val, NULL);
+        assert(err && err->code == PB_ERR_VARINT);
+        pb_error_free(err);
+        pb_buffer_discard(buf, pb_buffer_size(buf));
+    }
+    pb_buffer_write(buf, overflow, 3);
+    uint64_t val;
+    pb_error_t *err = varint_decode(buf, &val, NULL);
+    assert(err && err->code == PB_ERR_UNEXPECTED_EOF);
+    pb_error_free(err);
+    pb_buffer_free(buf);
+}
+
+// the kernel in use decodes and counts any slice of p as the portable one.
+static void check_varint_kernels(const uint8_t *p, size_t len) {
+    uint64_t vals[64], scalar_vals[64];
+    for (size_t off = 0; off < len; off += 1 + off % 61) {
+        for (size_t n = len - off; n > 0; n = n > 97 ? n - 97 : n - 1) {
+            size_t count = varint_count(p + off, n);
+            assert(count == varint_count_scalar(p + off, n));
+            size_t used = 0, scalar_used = 0;
+            size_t c = varint_decode_run(p + off, n, vals, 64, &used);
+            size_t scalar_c = varint_decode_run_scalar(p + off, n, scalar_vals, 64, &scalar_used);
+            assert(c == scalar_c && used == scalar_used);
+            assert(memcmp(vals, scalar_vals, c * sizeof(uint64_t)) == 0);
+        }
+    }
+}
+
+void test_varint_run() {
+    const size_t count = 2000;
+    uint64_t *expect = malloc(count * sizeof(uint64_t)), vals[64];
+    pb_buffer_t *buf = pb_buffer_new(count * 10);
+    srand(1);
+    for (int mode = 0; mode < 4; mode++) {
+        buf->read = buf->write = 0;
+        for (size_t i = 0; i < count; i++) {
+            // runs of small values, mixed lengths, long varints, and negative int32s among small values.
+            uint64_t v = (uint64_t) rand() * (uint64_t) rand();
+            switch (mode) {
+                case 0:
+                    v &= 0x7f;
+                    break;
+                case 1:
+                    v >>= rand() % 64;
+                    break;
+                case 3:
+                    v = i % 16 < 3 ? (uint64_t) (int64_t) -(rand() % 1000 + 1) : v & 0x7f;
+                    break;
+                default:
+                    v |= 1ULL << 63;
+                    break;
+            }
+            expect[i] = v;
+            varint_encode(buf, v);
+        }
+        const uint8_t *p = buf->payload;
+        size_t len = pb_buffer_size(buf), off = 0, n = 0;
+        assert(varint_count(p, len) == count);
+        while (off < len) {
+            size_t used = 0;
+            size_t c = varint_decode_run(p + off, len - off, vals, 64, &used);
+            assert(c > 0 && (c == 64 || off + used == len));
+            for (size_t i = 0; i < c; i++) {
+                assert(vals[i] == expect[n + i]);
+            }
+            n += c;
+            off += used;
+        }
+        assert(n == count);
+
+        // a truncated run stops before the last varint.
+        size_t used = 0;
+        size_t c = varint_decode_run(p, len - 1, expect, count, &used);
+        assert(c == count - 1 && (expect[count - 1] < 0x80) == (used == len - 1));
+        check_varint_kernels(p, len < 4096 ? len : 4096);
+    }
+    pb_buffer_free(buf);
+
+    uint8_t overflow[48];
+    memset(overflow, 0xff, sizeof(overflow));
+    size_t used = 0;
+    size_t c = varint_decode_run(overflow, sizeof(overflow), vals, 64, &used);
+    assert(c == 0 && used == 0);
+    check_varint_kernels(overflow, sizeof(overflow));
+
+    // a long varint inside a run is decoded alone, an overflow after it ends the run.
+    uint8_t mixed[96];
+    memset(mixed, 1, sizeof(mixed));
+    memset(mixed + 4, 0xff, 9);
+    memset(mixed + 64, 0xff, 16);
+    c = varint_decode_run(mixed, sizeof(mixed), vals, 64, &used);
+    assert(c == 4 + 1 + 50 && used == 64 && vals[4] == UINT64_MAX);
+    check_varint_kernels(mixed, sizeof(mixed));
+    free(expect);
+}
+
+void test_messages() {
+    pb_message_list_t *msgs = messages_new();
+    char name[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "pkg.M%d", i);
+        messages_append_msg(msgs, message_new(msgs, string_new(name)));
+    }
+    message_t *first = messages_find(msgs, string_new("pkg.M0"));
+    assert(first && first == messages_first(msgs));
+    pb_error_t *err = message_append_field(
+        first,
+        field_new(msgs, string_new("Child"), 1, PB_VAL_MESSAGE, field_opts_msg(false, string_new("pkg.M999")))
+    );
+    assert(err == NULL);
+    err = messages_link(msgs);
+    assert(err == NULL);
+
+    message_t *last = messages_find(msgs, string_new("pkg.M999"));
+    assert(last && last == rel_get(&msgs->last));
+    assert(field_msg(message_first(first)) == last);
+    assert(messages_find(msgs, string_new("type.googleapis.com/pkg.M999")) == last);
+    pb_string_t prefix = {.str="pkg.M10", .len=6};
+    assert(messages_find(msgs, prefix) == messages_find(msgs, string_new("pkg.M1")));
+    assert(!messages_find(msgs, string_new("pkg.M1000")));
+    assert(!messages_find(msgs, string_new("pkg.M")));
+    messages_free(msgs);
+}
+
+void test_message_fields() {
+    // dense tags are indexed directly, sparse ones searched, both appended out of order.
+    const uint64_t sparse[] = {100000, 7, 536870911, 300, 1};
+    for (int dense = 0; dense <= 1; dense++) {
+        pb_message_list_t *msgs = messages_new();
+        message_t *msg = message_new(msgs, string_new("pkg.Wide"));
+        messages_append_msg(msgs, msg);
+        size_t count = dense ? 250 : sizeof(sparse) / sizeof(sparse[0]);
+        for (size_t i = 0; i < count; i++) {
+            uint64_t tag = dense ? count - i : sparse[i];
+            message_append_field(msg, field_new(msgs, string_new("f"), tag, PB_VAL_INT32, field_opts_primitive(false, false)));
+        }
+        pb_error_t *err = messages_link(msgs);
+        assert(err == NULL);
+        assert(msg->field_count == count);
+        assert((msg->by_tag_len != 0) == dense);
+        for (size_t i = 0; i < count; i++) {
+            field_t *field = message_field(msg, i);
+            assert(field->ordinal == i);
+            assert(i == 0 || message_field(msg, i - 1)->tag < field->tag);
+            assert(message_find_field_by_tag(msg, field->tag) == field);
+        }
+        assert(!message_find_field_by_tag(msg, 0));
+        assert(!message_find_field_by_tag(msg, 251));
+        assert(!message_find_field_by_tag(msg, 1000));
+
+        message_append_field(msg, field_new(msgs, string_new("g"), 7, PB_VAL_INT32, field_opts_primitive(false, false)));
+        err = messages_link(msgs);
+        assert(err && err->code == PB_ERR_FAIL);
+        pb_error_free(err);
+        messages_free(msgs);
+    }
+}
+
+void test_arena() {
+    arena_t arena;
+    arena_init(&arena);
+    uint8_t *first = arena_alloc(&arena, 3);
+    uint8_t *second = arena_alloc(&arena, 16);
+    // objects follow each other, aligned and zeroed.
+    assert(second == first + 8 && (uintptr_t) second % 8 == 0);
+    for (size_t i = 0; i < 16; i++) {
+        assert(second[i] == 0);
+    }
+    // larger objects than a block get their own.
+    uint8_t *big = arena_alloc(&arena, 1 << 21);
+    assert(big && big[(1 << 21) - 1] == 0);
+
+    char name[] = "pkg.Name";
+    pb_string_t copy = arena_string(&arena, string_new(name));
+    assert(copy.str != name && copy.len == 8 && copy.str[copy.len] == '\0');
+    name[0] = 'x';
+    pb_string_t again = arena_string(&arena, string_new("pkg.Name"));
+    pb_string_t other = arena_string(&arena, string_new("pkg.Other"));
+    assert(again.str == copy.str && other.str != copy.str);
+    for (int i = 0; i < 1000; i++) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "s%d", i);
+        arena_string(&arena, string_new(buf));
+    }
+    again = arena_string(&arena, string_new("pkg.Name"));
+    assert(again.str == copy.str);
+    arena_free(&arena);
+}
+
+void test_descriptor() {
+    pb_buffer_t *buf = pb_buffer_new(1024);
+    pb_error_t *err = pb_read_file(buf, "build/testout/proto.pb");
+    assert(err == NULL);
+    pb_message_list_t *msgs = messages_new();
+    pb_buffer_t in = *buf;
+    err = pb_messages_parse_pb(&in, msgs);
+    assert(err == NULL);
+
+    message_t *user = messages_find(msgs, string_new("test.User"));
+    message_t *name = messages_find(msgs, string_new("test.User.UserName"));
+    assert(user && name);
+    // map entries become map fields, not messages.
+    assert(!messages_find(msgs, string_new("test.User.Int32mapEntry")));
+
+    field_t *field = message_find_field_by_tag(user, 32);
+    assert(field->type == PB_VAL_MAP && field_map_key(field)->type == PB_VAL_INT32 && field_map_val(field)->type == PB_VAL_STRING);
+    field = message_find_field_by_tag(user, 37);
+    assert(field->type == PB_VAL_MAP && field_map_key(field)->type == PB_VAL_STRING);
+    assert(field_map_val(field)->type == PB_VAL_MESSAGE && field_msg(field_map_val(field)) == name);
+    field = message_find_field_by_tag(user, 35);
+    assert(field->field_wire == WIRE_REPEATED && field_msg(field_array_element(field)) == name);
+    assert(message_find_field_by_tag(user, 36)->type == PB_VAL_ANY);
+    assert(message_find_field_by_tag(user, 31)->field_wire == WIRE_LENGTH_DELIMITED);
+    assert(message_find_field_by_tag(user, 8)->field_wire == WIRE_REPEATED);
+    assert(message_find_field_by_tag(name, 4)->type == PB_VAL_ENUM);
+    // the names of message types are kept once, fields follow their message.
+    assert(field_msg_name(field).str == message_name(name).str);
+    assert((uint8_t *) message_first(user) > (uint8_t *) user);
+    messages_free(msgs);
+
+    // a truncated set is an error.
+    msgs = messages_new();
+    pb_buffer_wrap(&in, buf->payload, pb_buffer_size(buf) - 1);
+    err = pb_messages_parse_pb(&in, msgs);
+    assert(err);
+    pb_error_free(err);
+    messages_free(msgs);
+    pb_buffer_free(buf);
+}
+
+void test_file() {
+    pb_buffer_t *buf = pb_buffer_new(1);
+    pb_error_t *err = pb_read_file(buf, "build/testout/proto.pb");
+    assert(err == NULL);
+
+    // regular files are mapped.
+    pb_file_t file;
+    err = pb_file_map(&file, "build/testout/proto.pb");
+    assert(err == NULL && file.mapped && file.size == pb_buffer_size(buf));
+    assert(memcmp(file.data, buf->payload, file.size) == 0);
+    pb_file_unmap(&file);
+    assert(!file.data && !file.mapped);
+
+    // files without a size are read until their end.
+    err = pb_file_map(&file, "/proc/self/stat");
+    assert(err == NULL && !file.mapped && file.size > 0);
+    pb_file_unmap(&file);
+
+    err = pb_file_map(&file, "build/testout/missing.pb");
+    assert(err);
+    pb_error_free(err);
+    pb_buffer_free(buf);
+}
+
+static void *registry_acquire(void *arg) {
+    pb_buffer_t in = *(pb_buffer_t *) arg;
+    pb_message_list_t *msgs = NULL;
+    pb_error_t *err = pb_messages_acquire(&in, &msgs);
+    assert(err == NULL);
+    return msgs;
+}
+
+void test_registry() {
+    pb_buffer_t *buf = pb_buffer_new(1024);
+    pb_error_t *err = pb_read_file(buf, "build/testout/proto.pb");
+    assert(err == NULL);
+
+    // the same bytes from any thread share one schema.
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        int rc = pthread_create(&threads[i], NULL, registry_acquire, buf);
+        assert(rc == 0);
+    }
+    pb_message_list_t *shared = registry_acquire(buf);
+    for (int i = 0; i < 4; i++) {
+        void *msgs;
+        int rc = pthread_join(threads[i], &msgs);
+        assert(rc == 0 && msgs == shared);
+    }
+    assert(messages_find(shared, string_new("test.User")));
+
+    // other bytes get their own.
+    pb_message_list_t *other = NULL;
+    pb_buffer_t *copy = pb_buffer_new(pb_buffer_size(buf) + 2);
+    pb_buffer_write(copy, buf->payload, pb_buffer_size(buf));
+    // an empty file appended to the set changes the bytes, not the messages.
+    const uint8_t empty_file[] = {0x0a, 0x00};
+    pb_buffer_write(copy, empty_file, sizeof(empty_file));
+    err = pb_messages_acquire(copy, &other);
+    assert(err == NULL && other != shared && messages_find(other, string_new("test.User")));
+    pb_messages_release(other);
+
+    // the same bytes at another address share it, the bytes are compared.
+    pb_message_list_t *same = NULL;
+    pb_buffer_t *same_bytes = pb_buffer_new(pb_buffer_size(buf));
+    pb_buffer_write(same_bytes, buf->payload, pb_buffer_size(buf));
+    err = pb_messages_acquire(same_bytes, &same);
+    assert(!err && same == shared);
+    pb_messages_release(same);
+    pb_buffer_free(same_bytes);
+
+    for (int i = 0; i < 5; i++) {
+        pb_messages_release(shared);
+    }
+
+    // a set that fails to parse is not registered.
+    pb_message_list_t *again = NULL;
+    pb_buffer_t *bad = pb_buffer_new(1);
+    pb_buffer_write(bad, (const uint8_t *) "\x0a", 1);
+    err = pb_messages_acquire(bad, &again);
+    assert(err && !again);
+    pb_error_free(err);
+    pb_buffer_free(bad);
+    pb_buffer_free(copy);
+    pb_buffer_free(buf);
+}
+
+static bool string_equal(pb_string_t a, pb_string_t b) {
+    return a.len == b.len && memcmp(a.str, b.str, a.len) == 0;
+}
+
+// the compiled field matches the parsed one, down to the messages it refers to.
+static void compiled_field_check(field_t *field, field_t *other) {
+    if (!field) {
+        assert(!other);
+        return;
+    }
+    assert(other && other->tag == field->tag && other->type == field->type);
+    assert(other->field_wire == field->field_wire && other->name_index == field->name_index);
+    assert(string_equal(field_name(other), field_name(field)));
+    assert(!field_msg(field) == !field_msg(other));
+    if (field_msg(field)) {
+        assert(string_equal(message_name(field_msg(other)), message_name(field_msg(field))));
+    }
+    compiled_field_check(field_array_element(field), field_array_element(other));
+    compiled_field_check(field_map_key(field), field_map_key(other));
+    compiled_field_check(field_map_val(field), field_map_val(other));
+}
+
+// the image with the 8 bytes at p damaged is rejected, p is restored after.
+static void compiled_corrupt_check(pb_buffer_t *buf, void *p) {
+    pb_message_list_t *compiled = NULL;
+    uint8_t *bytes = p;
+    bytes[3] ^= 0x40;
+    pb_error_t *err = pb_messages_map(buf->payload, pb_buffer_size(buf), &compiled);
+    assert(err && err->code == PB_ERR_FAIL);
+    pb_error_free(err);
+    bytes[3] ^= 0x40;
+}
+
+void test_compiled() {
+    pb_message_list_t *msgs = messages_new();
+    pb_error_t *err = pb_messages_parse_pbfile("build/testout/proto.pb", msgs);
+    assert(err == NULL);
+    pb_buffer_t *buf = pb_buffer_new(1024);
+    err = pb_messages_compile(msgs, buf);
+    assert(err == NULL);
+    err = pb_write_file(buf, "build/testout/proto.pbc");
+    assert(err == NULL);
+
+    // the image is used where it is mapped.
+    pb_file_t file;
+    pb_message_list_t *compiled = NULL;
+    err = pb_file_map(&file, "build/testout/proto.pbc");
+    assert(err == NULL && file.size == pb_buffer_size(buf));
+    err = pb_messages_map(file.data, file.size, &compiled);
+    assert(err == NULL);
+    assert(compiled->count == msgs->count && compiled->name_count == msgs->name_count);
+    size_t count = 0;
+    for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg), count++) {
+        message_t *other = messages_find(compiled, message_name(msg));
+        assert(other && other != msg && other->field_count == msg->field_count);
+        for (size_t i = 0; i < msg->field_count; i++) {
+            field_t *field = message_field(msg, i);
+            compiled_field_check(field, message_find_field_by_tag(other, field->tag));
+            compiled_field_check(field, message_field(other, i));
+        }
+    }
+    assert(count == compiled->count);
+    assert(!messages_find(compiled, string_new("test.Missing")));
+    pb_file_unmap(&file);
+
+    // offsets leading out of the image are found when it is loaded.
+    err = pb_messages_map(buf->payload, pb_buffer_size(buf), &compiled);
+    assert(err == NULL);
+    message_t *msg = messages_first(compiled);
+    while (msg && !msg->field_count) {
+        msg = message_next(msg);
+    }
+    assert(msg);
+    field_t *field = message_field(msg, 0);
+    compiled_corrupt_check(buf, &compiled->first);
+    compiled_corrupt_check(buf, &compiled->index);
+    compiled_corrupt_check(buf, (rel_t *) rel_get(&compiled->index) + compiled->index_cap - 1);
+    compiled_corrupt_check(buf, &compiled->any_type_field.str);
+    compiled_corrupt_check(buf, &compiled->count);
+    compiled_corrupt_check(buf, &msg->name.str);
+    compiled_corrupt_check(buf, &msg->fields);
+    compiled_corrupt_check(buf, rel_get(&msg->fields));
+    compiled_corrupt_check(buf, &msg->next);
+    compiled_corrupt_check(buf, &field->name.str);
+    compiled_corrupt_check(buf, &field->next);
+    for (message_t *m = messages_first(compiled); m; m = message_next(m)) {
+        for (size_t i = 0; i < m->field_count; i++) {
+            field_t *f = message_field(m, i);
+            if (field_msg(f)) {
+                compiled_corrupt_check(buf, &f->msg);
+            }
+            if (field_array_element(f)) {
+                compiled_corrupt_check(buf, &f->array_element);
+            }
+            if (field_map_val(f)) {
+                compiled_corrupt_check(buf, &field_map_val(f)->name.str);
+            }
+        }
+        if (m->by_tag_len) {
+            compiled_corrupt_check(buf, &m->by_tag);
+        }
+    }
+    err = pb_messages_map(buf->payload, pb_buffer_size(buf), &compiled);
+    assert(err == NULL);
+
+    // only images of the same layout are loaded, and only whole.
+    err = pb_messages_map(buf->payload, pb_buffer_size(buf) - 8, &compiled);
+    assert(err);
+    pb_error_free(err);
+    buf->payload[0] = 'X';
+    err = pb_messages_map(buf->payload, pb_buffer_size(buf), &compiled);
+    assert(err);
+    pb_error_free(err);
+    pb_buffer_free(buf);
+    messages_free(msgs);
+}
+
+static double bench_elapsed_ns(clock_t start, size_t ops) {
+    return (double) (clock() - start) * 1e9 / CLOCKS_PER_SEC / (double) ops;
+}
+
+void bench_codec() {
+    const size_t count = 4096, rounds = 1000;
+    const struct {
+        size_t bytes;
+        uint64_t val;
+    } cases[] = {
+        {1,  1},
+        {2,  300},
+        {5,  1ULL << 32},
+        {10, UINT64_MAX},
+    };
+    pb_buffer_t *buf = pb_buffer_new(count * 10);
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        clock_t start = clock();
+        for (size_t r = 0; r < rounds; r++) {
+            buf->read = buf->write = 0;
+            for (size_t i = 0; i < count; i++) {
+                varint_encode(buf, cases[c].val);
+            }
+        }
+        printf("varint_encode %2zu bytes: %6.2f ns/op\n", cases[c].bytes, bench_elapsed_ns(start, count * rounds));
+        assert(pb_buffer_size(buf) == count * cases[c].bytes);
+
+        uint64_t sum = 0, val;
+        start = clock();
+        for (size_t r = 0; r < rounds; r++) {
+            buf->read = 0;
+            while (pb_buffer_size(buf) > 0) {
+                varint_decode(buf, &val, NULL);
+                sum += val;
+            }
+        }
+        printf("varint_decode %2zu bytes: %6.2f ns/op (%llu)\n",
+               cases[c].bytes, bench_elapsed_ns(start, count * rounds), (unsigned long long) (sum & 1));
+    }
+    pb_buffer_free(buf);
+}
+
+/**
+ * heap allocations are counted while the lua scripts ask for it. lua allocates through its own
+ * allocator, so only the allocations of pblua are counted.
+ */
+static bool alloc_counting = false;
+static size_t alloc_count = 0;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void __libc_free(void *);
+
+void *malloc(size_t size) {
+    alloc_count += alloc_counting;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    alloc_count += alloc_counting;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size) {
+    alloc_count += alloc_counting;
+    return __libc_realloc(p, size);
+}
+
+void free(void *p) {
+    __libc_free(p);
+}
+
+static void *test_lua_alloc(void *ud, void *p, size_t osize, size_t nsize) {
+    if (nsize == 0) {
+        __libc_free(p);
+        return NULL;
+    }
+    return __libc_realloc(p, nsize);
+}
+#else
+static void *test_lua_alloc(void *ud, void *p, size_t osize, size_t nsize) {
+    if (nsize == 0) {
+        free(p);
+        return NULL;
+    }
+    return realloc(p, nsize);
+}
+#endif
+
+// alloc_counting(on) starts counting from zero or stops.
+static int test_alloc_counting(lua_State *lstate) {
+    alloc_counting = lua_toboolean(lstate, 1);
+    if (alloc_counting) {
+        alloc_count = 0;
+    }
+    return 0;
+}
+
+static int test_alloc_count(lua_State *lstate) {
+    lua_pushinteger(lstate, (lua_Integer) alloc_count);
+    return 1;
+}
+
 void test_lua_call_c(const char *lua_file) {
-    lua_State *lstate = luaL_newstate();
+    lua_State *lstate = lua_newstate(test_lua_alloc, NULL);
     luaL_openlibs(lstate);
+    lua_register(lstate, "alloc_counting", test_alloc_counting);
+    lua_register(lstate, "alloc_count", test_alloc_count);
     pblua_compat_requiref(lstate, "pblua", luaopen_pblua, 1);
     lua_pop(lstate, 1);
 
@@ -81,10 +684,30 @@ void test_decode_message() {
     test_lua_call_c("test/decode.lua");
 }
 
+void test_alloc_message() {
+    test_lua_call_c("test/alloc.lua");
+}
+
+void bench_message() {
+    test_lua_call_c("test/bench.lua");
+}
+
 int main() {
     test_buffer();
     test_encoding();
+    test_varint();
+    test_varint_run();
+    test_messages();
+    test_message_fields();
+    test_arena();
+    test_file();
+    test_descriptor();
+    test_registry();
+    test_compiled();
+    bench_codec();
     test_encode_message();
     test_decode_message();
+    test_alloc_message();
+    bench_message();
     return 0;
 }
@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <string.h>
+#include "../pb/pb.h"
+#include "../pb/common.h"
+
+/**
+ * descgen compiles a FileDescriptorSet into C: the messages and fields of the schema as static
+ * const data, already linked and indexed, so the schema is used without being parsed.
+ *
+ *   descgen descriptor.pb > descriptor_gen.c
+ */
+typedef struct {
+    message_t **msgs;
+    size_t msg_count;
+    field_t **fields;
+    size_t field_count;
+
+    // the string table, the strings point into the schema being compiled.
+    pb_string_t *strs;
+    size_t *str_offsets;
+    size_t str_count;
+    size_t str_size;
+} gen_t;
+
+static const char *valtype_name(pb_valtype_t t) {
+    switch (t) {
+        case PB_VAL_DOUBLE:
+            return "PB_VAL_DOUBLE";
+        case PB_VAL_FLOAT:
+            return "PB_VAL_FLOAT";
+        case PB_VAL_INT64:
+            return "PB_VAL_INT64";
+        case PB_VAL_UINT64:
+            return "PB_VAL_UINT64";
+        case PB_VAL_INT32:
+            return "PB_VAL_INT32";
+        case PB_VAL_FIXED64:
+            return "PB_VAL_FIXED64";
+        case PB_VAL_FIXED32:
+            return "PB_VAL_FIXED32";
+        case PB_VAL_BOOL:
+            return "PB_VAL_BOOL";
+        case PB_VAL_STRING:
+            return "PB_VAL_STRING";
+        case PB_VAL_MESSAGE:
+            return "PB_VAL_MESSAGE";
+        case PB_VAL_BYTES:
+            return "PB_VAL_BYTES";
+        case PB_VAL_UINT32:
+            return "PB_VAL_UINT32";
+        case PB_VAL_ENUM:
+            return "PB_VAL_ENUM";
+        case PB_VAL_SFIXED32:
+            return "PB_VAL_SFIXED32";
+        case PB_VAL_SFIXED64:
+            return "PB_VAL_SFIXED64";
+        case PB_VAL_SINT32:
+            return "PB_VAL_SINT32";
+        case PB_VAL_SINT64:
+            return "PB_VAL_SINT64";
+        case PB_VAL_ANY:
+            return "PB_VAL_ANY";
+        case PB_VAL_MAP:
+            return "PB_VAL_MAP";
+        default:
+            return "0";
+    }
+}
+
+static const char *wire_const_name(wire_t w) {
+    switch (w) {
+        case WIRE_VARINT:
+            return "WIRE_VARINT";
+        case WIRE_BIT64:
+            return "WIRE_BIT64";
+        case WIRE_BIT32:
+            return "WIRE_BIT32";
+        case WIRE_LENGTH_DELIMITED:
+            return "WIRE_LENGTH_DELIMITED";
+        default:
+            return "WIRE_REPEATED";
+    }
+}
+
+static void gen_add_field(gen_t *g, field_t *field) {
+    if (!field) {
+        return;
+    }
+    g->fields = realloc(g->fields, (g->field_count + 1) * sizeof(field_t *));
+    g->fields[g->field_count++] = field;
+    gen_add_field(g, field_array_element(field));
+    gen_add_field(g, field_map_key(field));
+    gen_add_field(g, field_map_val(field));
+}
+
+static size_t gen_field_id(gen_t *g, field_t *field) {
+    for (size_t i = 0; i < g->field_count; i++) {
+        if (g->fields[i] == field) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static size_t gen_msg_id(gen_t *g, message_t *msg) {
+    for (size_t i = 0; i < g->msg_count; i++) {
+        if (g->msgs[i] == msg) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// the offset of s in the string table, every string is kept once and terminated by a zero.
+static size_t gen_string_offset(gen_t *g, pb_string_t s) {
+    for (size_t i = 0; i < g->str_count; i++) {
+        if (g->strs[i].len == s.len && memcmp(g->strs[i].str, s.str, s.len) == 0) {
+            return g->str_offsets[i];
+        }
+    }
+    g->strs = realloc(g->strs, (g->str_count + 1) * sizeof(pb_string_t));
+    g->str_offsets = realloc(g->str_offsets, (g->str_count + 1) * sizeof(size_t));
+    g->strs[g->str_count] = s;
+    g->str_offsets[g->str_count++] = g->str_size;
+    g->str_size += s.len + 1;
+    return g->str_size - s.len - 1;
+}
+
+// the members are named by their path in desc_schema_t, the offsets are taken between the paths.
+#define GEN_PATH_MAX 64
+
+static void gen_string(gen_t *g, const char *from, pb_string_t s) {
+    if (!s.str) {
+        printf("{0, 0}");
+        return;
+    }
+    printf("{DESC_REL(%s.str, strings[%zu]), %zu}", from, gen_string_offset(g, s), s.len);
+}
+
+static void gen_field_ref(gen_t *g, const char *from, field_t *field) {
+    if (field) {
+        printf("DESC_REL(%s, fields[%zu])", from, gen_field_id(g, field));
+    } else {
+        printf("0");
+    }
+}
+
+static void gen_msg_ref(gen_t *g, const char *from, message_t *msg) {
+    if (msg) {
+        printf("DESC_REL(%s, messages[%zu])", from, gen_msg_id(g, msg));
+    } else {
+        printf("0");
+    }
+}
+
+static const char *gen_path(char *path, const char *table, size_t id, const char *member) {
+    snprintf(path, GEN_PATH_MAX, member ? "%s[%zu].%s" : "%s[%zu]", table, id, member);
+    return path;
+}
+
+static void gen_key(field_key_t *key) {
+    printf("{%u, %u, {", key->len, key->wire);
+    for (uint8_t i = 0; i < key->len; i++) {
+        printf("%s0x%02x", i ? ", " : "", key->bytes[i]);
+    }
+    printf("}}");
+}
+
+static void gen_field(gen_t *g, size_t id) {
+    field_t *field = g->fields[id];
+    char path[GEN_PATH_MAX];
+    printf("        [%zu] = {\n            .name = ", id);
+    gen_string(g, gen_path(path, "fields", id, "name"), field_name(field));
+    printf(",\n            .tag = %llu,\n", (unsigned long long) field->tag);
+    printf("            .type = %s,\n", valtype_name(field->type));
+    printf("            .value_wire = %s,\n", wire_const_name(field->value_wire));
+    printf("            .field_wire = %s,\n", wire_const_name(field->field_wire));
+    printf("            .repeated = %s,\n", field->repeated ? "true" : "false");
+    printf("            .packed = %s,\n", field->packed ? "true" : "false");
+    printf("            .map_key_type = %s,\n", valtype_name(field->map_key_type));
+    printf("            .map_value_type = %s,\n", valtype_name(field->map_value_type));
+    printf("            .msg_name = ");
+    gen_string(g, gen_path(path, "fields", id, "msg_name"), field_msg_name(field));
+    printf(",\n            .value_key = ");
+    gen_key(&field->value_key);
+    printf(",\n            .packed_key = ");
+    gen_key(&field->packed_key);
+    printf(",\n            .array_element = ");
+    gen_field_ref(g, gen_path(path, "fields", id, "array_element"), field_array_element(field));
+    printf(",\n            .map_key = ");
+    gen_field_ref(g, gen_path(path, "fields", id, "map_key"), field_map_key(field));
+    printf(",\n            .map_val = ");
+    gen_field_ref(g, gen_path(path, "fields", id, "map_val"), field_map_val(field));
+    printf(",\n            .msg = ");
+    gen_msg_ref(g, gen_path(path, "fields", id, "msg"), field_msg(field));
+    printf(",\n            .ordinal = %zu,\n            .name_index = %zu,\n            .next = ",
+           field->ordinal, field->name_index);
+    gen_field_ref(g, gen_path(path, "fields", id, "next"), field_next(field));
+    printf(",\n        },\n");
+}
+
+static void gen_message(gen_t *g, size_t id, size_t fields, size_t by_tag) {
+    message_t *msg = g->msgs[id];
+    char path[GEN_PATH_MAX];
+    printf("        [%zu] = {\n            .name = ", id);
+    gen_string(g, gen_path(path, "messages", id, "name"), message_name(msg));
+    printf(",\n            .hash = 0x%016llxULL,\n            .first = ", (unsigned long long) msg->hash);
+    gen_field_ref(g, gen_path(path, "messages", id, "first"), message_first(msg));
+    printf(",\n            .last = ");
+    gen_field_ref(g, gen_path(path, "messages", id, "last"), rel_get(&msg->last));
+    printf(",\n            .fields = DESC_REL(messages[%zu].fields, message_fields[%zu]),\n", id, fields);
+    printf("            .field_count = %zu,\n", msg->field_count);
+    if (msg->by_tag_len) {
+        printf("            .by_tag = DESC_REL(messages[%zu].by_tag, by_tag[%zu]),\n", id, by_tag);
+    } else {
+        printf("            .by_tag = 0,\n");
+    }
+    printf("            .by_tag_len = %zu,\n            .next = ", msg->by_tag_len);
+    gen_msg_ref(g, gen_path(path, "messages", id, "next"), message_next(msg));
+    printf(",\n        },\n");
+}
+
+static void gen_list(gen_t *g, pb_message_list_t *msgs) {
+    printf("    .list = {\n        .first = ");
+    if (messages_first(msgs)) {
+        printf("DESC_REL(list.first, messages[%zu])", gen_msg_id(g, messages_first(msgs)));
+    } else {
+        printf("0");
+    }
+    printf(",\n        .last = ");
+    if (rel_get(&msgs->last)) {
+        printf("DESC_REL(list.last, messages[%zu])", gen_msg_id(g, rel_get(&msgs->last)));
+    } else {
+        printf("0");
+    }
+    printf(",\n        .index = DESC_REL(list.index, index[0]),\n");
+    printf("        .index_cap = %zu,\n        .count = %zu,\n", msgs->index_cap, msgs->count);
+    pb_string_t any_type = rel_string(&msgs->any_type_field),
+        any_value = rel_string(&msgs->any_value_field);
+    printf("        .any_type_field = {DESC_REL(list.any_type_field.str, strings[%zu]), %zu},\n",
+           gen_string_offset(g, any_type), any_type.len);
+    printf("        .any_value_field = {DESC_REL(list.any_value_field.str, strings[%zu]), %zu},\n",
+           gen_string_offset(g, any_value), any_value.len);
+    printf("        .name_count = %zu,\n    },\n", msgs->name_count);
+}
+
+static void gen(pb_message_list_t *msgs) {
+    gen_t g = {};
+    for (message_t *msg = messages_first(msgs); msg; msg = message_next(msg)) {
+        g.msgs = realloc(g.msgs, (g.msg_count + 1) * sizeof(message_t *));
+        g.msgs[g.msg_count++] = msg;
+        for (field_t *field = message_first(msg); field; field = field_next(field)) {
+            gen_add_field(&g, field);
+        }
+    }
+    size_t field_refs = 0, by_tag_refs = 0;
+    for (size_t i = 0; i < g.msg_count; i++) {
+        field_refs += g.msgs[i]->field_count;
+        by_tag_refs += g.msgs[i]->by_tag_len;
+        gen_string_offset(&g, message_name(g.msgs[i]));
+    }
+    // the size of the string table is part of the type, so it is filled before anything is written.
+    for (size_t i = 0; i < g.field_count; i++) {
+        gen_string_offset(&g, field_name(g.fields[i]));
+        if (field_msg_name(g.fields[i]).str) {
+            gen_string_offset(&g, field_msg_name(g.fields[i]));
+        }
+    }
+    gen_string_offset(&g, rel_string(&msgs->any_type_field));
+    gen_string_offset(&g, rel_string(&msgs->any_value_field));
+    char path[GEN_PATH_MAX];
+
+    // the whole schema is one object, so the offsets between its members are constants.
+    printf("// generated by tools/descgen from pb/descriptor.proto, do not edit.\n");
+    printf("#include <stddef.h>\n#include \"pb.h\"\n#include \"common.h\"\n\n");
+    printf("typedef struct {\n");
+    printf("    pb_message_list_t list;\n");
+    printf("    message_t messages[%zu];\n", g.msg_count);
+    printf("    field_t fields[%zu];\n", g.field_count);
+    printf("    rel_t message_fields[%zu];\n", field_refs ? field_refs : 1);
+    printf("    rel_t by_tag[%zu];\n", by_tag_refs ? by_tag_refs : 1);
+    printf("    rel_t index[%zu];\n", msgs->index_cap ? msgs->index_cap : 1);
+
+    printf("    char strings[%zu];\n} desc_schema_t;\n\n", g.str_size ? g.str_size : 1);
+    printf("#define DESC_REL(from, to) ((rel_t) offsetof(desc_schema_t, to) - (rel_t) offsetof(desc_schema_t, from))\n\n");
+    printf("static const desc_schema_t desc_schema = {\n");
+    gen_list(&g, msgs);
+    printf("    .messages = {\n");
+    size_t fields = 0, by_tag = 0;
+    for (size_t i = 0; i < g.msg_count; i++) {
+        gen_message(&g, i, fields, by_tag);
+        fields += g.msgs[i]->field_count;
+        by_tag += g.msgs[i]->by_tag_len;
+    }
+    printf("    },\n    .fields = {\n");
+    for (size_t i = 0; i < g.field_count; i++) {
+        gen_field(&g, i);
+    }
+    // the field tables of every message, one after the other.
+    printf("    },\n    .message_fields = {\n");
+    fields = 0;
+    for (size_t i = 0; i < g.msg_count; i++) {
+        for (size_t j = 0; j < g.msgs[i]->field_count; j++, fields++) {
+            printf("        ");
+            gen_field_ref(&g, gen_path(path, "message_fields", fields, NULL), message_field(g.msgs[i], j));
+            printf(",\n");
+        }
+    }
+    printf("    },\n    .by_tag = {\n");
+    by_tag = 0;
+    for (size_t i = 0; i < g.msg_count; i++) {
+        for (size_t j = 0; j < g.msgs[i]->by_tag_len; j++, by_tag++) {
+            printf("        ");
+            gen_field_ref(&g, gen_path(path, "by_tag", by_tag, NULL), rel_table_get(&g.msgs[i]->by_tag, j));
+            printf(",\n");
+        }
+    }
+    printf("    },\n    .index = {\n");
+    for (size_t i = 0; i < msgs->index_cap; i++) {
+        printf("        ");
+        gen_msg_ref(&g, gen_path(path, "index", i, NULL), rel_table_get(&msgs->index, i));
+        printf(",\n");
+    }
+    printf("    },\n    .strings = \"");
+    for (size_t i = 0; i < g.str_count; i++) {
+        for (size_t j = 0; j < g.strs[i].len; j++) {
+            unsigned char c = (unsigned char) g.strs[i].str[j];
+            if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\') {
+                printf("\\%03o", c);
+            } else {
+                putchar(c);
+            }
+        }
+        // the last terminator is the one of the literal.
+        if (i + 1 < g.str_count) {
+            printf("\\000");
+        }
+    }
+    printf("\",\n};\n\n");
+    printf("pb_message_list_t *pb_messages_descriptor() {\n");
+    printf("    return (pb_message_list_t *) &desc_schema.list;\n}\n");
+
+    free(g.msgs);
+    free(g.fields);
+    free(g.strs);
+    free(g.str_offsets);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s descriptor.pb\n", argv[0]);
+        return 1;
+    }
+    pb_buffer_t *buf = pb_buffer_new(1024);
+    pb_message_list_t *msgs = messages_new();
+    pb_error_t *err = pb_read_file(buf, argv[1]);
+    if (!err) {
+        err = pb_messages_parse_pb(buf, msgs);
+    }
+    if (err) {
+        fprintf(stderr, "%s\n", err->msg);
+        pb_error_free(err);
+        return 1;
+    }
+    gen(msgs);
+    messages_free(msgs);
+    pb_buffer_free(buf);
+    return 0;
+}